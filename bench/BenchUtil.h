@@ -0,0 +1,16 @@
+// BenchUtil.h
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+#include <chrono>
+
+//Wall-clock seconds one call of fn takes
+template <typename Fn>
+inline double secondsFor(Fn&& fn) {
+    auto start = std::chrono::high_resolution_clock::now();
+    fn();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+#endif
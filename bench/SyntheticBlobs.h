@@ -0,0 +1,54 @@
+// SyntheticBlobs.h
+#ifndef SYNTHETICBLOBS_H
+#define SYNTHETICBLOBS_H
+
+#include <vector>
+#include <random>
+#include <cstddef>
+
+// Seeded Gaussian blobs for benchmarks that must not depend on a private
+// dataset. Cluster centers are drawn uniformly from [-spread, spread]^dims and
+// each cluster point is its center plus N(0, sigma) per coordinate; a `noise`
+// fraction of the points is uniform over the same box. Points come out in
+// random cluster order, so any prefix or batch mixes every cluster. Coordinates
+// are rounded through float, as the .npy embeddings are.
+struct BlobConfig {
+    size_t points = 100000;
+    int dimensions = 16;
+    int clusters = 20;
+    double noise = 0.05;
+    double sigma = 0.05;
+    double spread = 1.0;
+    unsigned seed = 42;
+};
+
+//Generate the blobs; truth, if given, receives each point's cluster (-1 for noise)
+inline std::vector<std::vector<double>> makeBlobs(const BlobConfig& config, std::vector<int>* truth = nullptr) {
+    std::mt19937_64 g(config.seed);
+    std::uniform_real_distribution<double> box(-config.spread, config.spread);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_int_distribution<int> pick(0, config.clusters - 1);
+    std::normal_distribution<double> normal(0.0, config.sigma);
+
+    std::vector<std::vector<double>> centers(config.clusters, std::vector<double>(config.dimensions));
+    for (auto& center : centers) {
+        for (double& x : center) x = box(g);
+    }
+
+    std::vector<std::vector<double>> points(config.points, std::vector<double>(config.dimensions));
+    if (truth) truth->assign(config.points, -1);
+    for (size_t i = 0; i < config.points; ++i) {
+        std::vector<double>& p = points[i];
+        if (config.clusters == 0 || unit(g) < config.noise) {
+            for (double& x : p) x = box(g);
+        } else {
+            int c = pick(g);
+            for (int k = 0; k < config.dimensions; ++k) p[k] = centers[c][k] + normal(g);
+            if (truth) (*truth)[i] = c;
+        }
+        for (double& x : p) x = static_cast<double>(static_cast<float>(x));
+    }
+    return points;
+}
+
+#endif
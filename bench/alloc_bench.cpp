@@ -0,0 +1,71 @@
+// Heap allocations in the clustering loops: operator new and new[] are counted, then
+// DBSCAN runs on the first 20000 seeded blob points and INCDBSCAN inserts
+// the rest in batches of 10000, on KDTree (one node per insert) and on a
+// reserved ArenaKDTree. The neighborhood cache is off, as it allocates by
+// design to hold its byte budget; what remains is the index's own storage.
+#include <cstdlib>
+#include <new>
+
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+
+//Kept out of line so GCC does not flag free() on what operator new returned
+[[gnu::noinline]] static void release(void* p) noexcept { std::free(p); }
+void operator delete(void* p) noexcept { release(p); }
+void operator delete(void* p, size_t) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete[](void* p, size_t) noexcept { release(p); }
+
+#include "SyntheticBlobs.h"
+#include "KDTree.h"
+#include "ArenaKDTree.h"
+#include "DBSCAN.h"
+#include "INCDBSCAN.h"
+#include "BenchUtil.h"
+#include <iostream>
+
+static void run(const char* name, NeighborIndex& tree, const std::vector<std::vector<double>>& points, double eps) {
+    tree.setCacheBudget(0);
+    size_t initial = 20000, batch = 10000;
+    int clusterId = 0;
+    std::vector<std::vector<double>> first(points.begin(), points.begin() + initial);
+    size_t before = allocations;
+    double seconds = secondsFor([&] {
+        DBSCAN dbscan(eps, 5, tree, clusterId);
+        dbscan.cluster(first);
+    });
+    std::cout << name << " DBSCAN on " << initial << " points: " << allocations - before << " allocations, " << seconds << " s" << std::endl;
+
+    INCDBSCAN incdbscan(eps, 5, tree);
+    for (size_t start = initial; start + batch <= points.size(); start += batch) {
+        std::vector<std::vector<double>> next(points.begin() + start, points.begin() + start + batch);
+        before = allocations;
+        seconds = secondsFor([&] {
+            incdbscan.cluster(next, clusterId, static_cast<int>(start));
+            incdbscan.getLastClusterId(clusterId);
+        });
+        std::cout << name << " INCDBSCAN batch of " << batch << ": " << allocations - before << " allocations, " << seconds << " s" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    BlobConfig config;
+    config.points = argc > 1 ? std::stoul(argv[1]) : 60000;
+    config.dimensions = argc > 2 ? std::stoi(argv[2]) : 8;
+    config.sigma = 0.1;
+    std::vector<std::vector<double>> points = makeBlobs(config);
+    Metrics::setLogging(false);
+
+    KDTree tree(config.dimensions);
+    run("KDTree", tree, points, 0.25);
+    ArenaKDTree arena(config.dimensions);
+    arena.reserve(points.size());
+    run("ArenaKDTree (reserved)", arena, points, 0.25);
+    return 0;
+}
@@ -0,0 +1,70 @@
+// All eps-neighborhoods of the embeddings main.cpp loads, computed by the
+// tiled BruteForceEngine and by per-point KDTree queries: agreement with the
+// tree, time per tile configuration and thread count, and full DBSCAN runs.
+#include "KDTree.h"
+#include "BruteForceEngine.h"
+#include "DBSCAN.h"
+#include "NpyDataset.h"
+#include "BenchUtil.h"
+#include <iostream>
+#include <numeric>
+
+int main(int argc, char** argv) {
+    std::string base_dir = argc > 1 ? argv[1] : "./../python/TESTING_SET/";
+    double eps = argc > 2 ? std::stod(argv[2]) : 1.0;
+    int minPts = 5;
+    int dimensions = 512;
+
+    std::vector<std::string> labels;
+    std::vector<std::vector<double>> points = convertToDouble(load_npy_files(base_dir, labels));
+    std::cout << "Loaded " << points.size() << " points" << std::endl;
+    if (points.empty()) return 1;
+
+    std::vector<int> queryIds(points.size());
+    std::iota(queryIds.begin(), queryIds.end(), 0);
+
+    KDTree kdTree(dimensions);
+    kdTree.build(points, 0);
+    std::vector<int> ids;
+    size_t treeNeighbors = 0;
+    double treeSeconds = secondsFor([&] {
+        for (int id : queryIds) {
+            kdTree.radiusSearchById(id, eps, ids);
+            treeNeighbors += ids.size();
+        }
+    });
+    std::cout << "KDTree per-point queries: " << treeSeconds << " s, " << treeNeighbors << " neighbors" << std::endl;
+
+    BruteForceEngine engine(dimensions);
+    engine.build(points, 0);
+    std::cout << "Mismatching neighborhoods vs KDTree: " << engine.countMismatches(kdTree, queryIds, eps) << std::endl;
+
+    std::vector<int> offsets;
+    for (int threads : {1, 0}) {
+        engine.setNumThreads(threads);
+        for (auto tiles : {std::vector<int>{16, 32, 64}, std::vector<int>{32, 64, 128}, std::vector<int>{64, 128, 256}, std::vector<int>{32, 256, 512}}) {
+            engine.setTileSizes(tiles[0], tiles[1], tiles[2]);
+            double seconds = secondsFor([&] { engine.radiusSearchBatch(queryIds, eps, offsets, ids); });
+            std::cout << "BruteForceEngine threads=" << (threads ? threads : -1) << " tiles " << tiles[0] << "x" << tiles[1] << "x" << tiles[2]
+                      << ": " << seconds << " s, " << ids.size() << " neighbors" << std::endl;
+        }
+    }
+
+    //Full clustering on both backends must give the same labels
+    std::vector<int> treeLabels, engineLabels;
+    int treeClusters = 0, engineClusters = 0;
+    KDTree clusterTree(dimensions);
+    DBSCAN treeDbscan(eps, minPts, clusterTree, treeClusters);
+    double treeCluster = secondsFor([&] { treeDbscan.cluster(points); });
+    treeDbscan.getClustersLabels(treeLabels, treeClusters);
+
+    BruteForceEngine clusterEngine(dimensions);
+    clusterEngine.setNumThreads(0);
+    DBSCAN engineDbscan(eps, minPts, clusterEngine, engineClusters);
+    double engineCluster = secondsFor([&] { engineDbscan.cluster(points); });
+    engineDbscan.getClustersLabels(engineLabels, engineClusters);
+
+    std::cout << "DBSCAN KDTree: " << treeCluster << " s, BruteForceEngine: " << engineCluster << " s, labels "
+              << (treeLabels == engineLabels ? "identical" : "DIFFERENT") << std::endl;
+    return 0;
+}
@@ -0,0 +1,71 @@
+// Export of cluster assignments for n points (default 1M): the per-point
+// ofstream loop main.cpp used to run (timed on a sample and scaled up), then
+// NeighborIndex::clusterLabels with CsvLabelWriter and with BinaryLabelWriter.
+// The CSV and binary output are read back and compared with the labels.
+#include "BruteForceEngine.h"
+#include "LabelWriter.h"
+#include "BenchUtil.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <cstdio>
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    int sample = std::min(n, 10000);
+    std::string csvPath = "export_bench.txt";
+    std::string binaryPath = "export_bench.bin";
+
+    //Labels live in the index; a few thousand clusters, some merged, 10% noise
+    std::mt19937 g(7);
+    std::uniform_real_distribution<double> coordinate(0.0, 1.0);
+    std::uniform_int_distribution<int> cluster(0, 4999);
+    std::vector<std::vector<double>> points(n, std::vector<double>(2));
+    for (auto& p : points) p = {coordinate(g), coordinate(g)};
+    BruteForceEngine index(2);
+    index.build(points, 0);
+    std::vector<std::string> names(n);
+    for (int id = 0; id < n; ++id) {
+        index.assignClusterIdById(id, id % 10 == 0 ? -1 : cluster(g));
+        names[id] = "class_" + std::to_string(id % 100);
+    }
+    for (int c = 0; c < 5000; c += 7) index.mergeClusters(c, c + 3);
+
+    std::remove(csvPath.c_str());
+    double perPoint = secondsFor([&] {
+        for (int id = 0; id < sample; ++id) {
+            std::ofstream outfile(csvPath, std::ios_base::app);
+            outfile << names[id] + "," + std::to_string(index.getClusterIdById(id)) << std::endl;
+            outfile.close();
+        }
+    });
+    std::cout << "Per-point ofstream: " << perPoint << " s for " << sample << " rows, about " << perPoint * n / sample << " s for " << n << std::endl;
+
+    std::vector<int> labels;
+    double labelSeconds = secondsFor([&] { index.clusterLabels(labels); });
+    double csvSeconds = secondsFor([&] {
+        CsvLabelWriter writer(csvPath);
+        writer.write(names, labels.data());
+        writer.close();
+    });
+    double binarySeconds = secondsFor([&] { BinaryLabelWriter::save(binaryPath, labels, names); });
+    std::cout << "clusterLabels: " << labelSeconds << " s, CsvLabelWriter: " << csvSeconds << " s, BinaryLabelWriter: " << binarySeconds
+              << " s for " << n << " rows" << std::endl;
+
+    bool same = true;
+    std::ifstream csv(csvPath);
+    std::string line;
+    for (int id = 0; id < n && same; ++id) {
+        same = std::getline(csv, line) && line == names[id] + "," + std::to_string(index.getClusterIdById(id));
+    }
+    std::vector<int> clusters, nameIds;
+    std::vector<std::string> table;
+    BinaryLabelWriter::load(binaryPath, clusters, nameIds, table);
+    same = same && clusters == labels;
+    for (int id = 0; id < n && same; ++id) same = table[nameIds[id]] == names[id];
+    std::cout << "Read back: " << (same ? "identical" : "DIFFERENT") << std::endl;
+    std::remove(csvPath.c_str());
+    std::remove(binaryPath.c_str());
+    return same ? 0 : 1;
+}
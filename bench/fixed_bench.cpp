@@ -0,0 +1,63 @@
+// The runtime-dimension trees against FixedKDTree at 512 dimensions (double
+// and float rows) on seeded Gaussian blobs: bulk load, one radius query per
+// stored point, and DBSCAN + INCDBSCAN over the same points, whose labels must
+// match KDTree's. Build with -march=native to get the inline fixed-width
+// distance loop instead of the dispatched kernels.
+#include "SyntheticBlobs.h"
+#include "FixedKDTree.h"
+#include "ArenaKDTree.h"
+#include "DBSCAN.h"
+#include "INCDBSCAN.h"
+#include "BenchUtil.h"
+#include <iostream>
+
+template <typename Tree>
+static void run(const std::string& name, const std::vector<std::vector<double>>& points, double eps, std::vector<int>& reference) {
+    Tree index(512);
+    double buildSeconds = secondsFor([&] { index.build(points, 0); });
+    std::vector<int> ids;
+    size_t found = 0;
+    double querySeconds = secondsFor([&] {
+        for (int id = 0; id < static_cast<int>(points.size()); ++id) {
+            index.radiusSearchById(id, eps, ids);
+            found += ids.size();
+        }
+    });
+
+    //Cluster the first half, then add the second as one INCDBSCAN batch
+    Tree fresh(512);
+    size_t half = points.size() / 2;
+    std::vector<int> labels;
+    double clusterSeconds = secondsFor([&] {
+        int nextClusterId = 0;
+        DBSCAN dbscan(eps, 5, fresh, nextClusterId);
+        dbscan.cluster(std::vector<std::vector<double>>(points.begin(), points.begin() + half));
+        INCDBSCAN incdbscan(eps, 5, fresh);
+        incdbscan.cluster(std::vector<std::vector<double>>(points.begin() + half, points.end()), nextClusterId, static_cast<int>(half));
+        fresh.clusterLabels(labels);
+    });
+    if (reference.empty()) reference = labels;
+    size_t differ = 0;
+    for (size_t i = 0; i < labels.size(); ++i) differ += labels[i] != reference[i];
+    std::cout << name << ": build " << buildSeconds << " s, " << points.size() / querySeconds << " queries/s (" << found / points.size()
+              << " neighbors each), DBSCAN + INCDBSCAN " << clusterSeconds << " s, " << differ << " labels differ from KDTree" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    BlobConfig config;
+    config.points = argc > 1 ? std::stoul(argv[1]) : 20000;
+    config.dimensions = 512;
+    config.sigma = 0.02;
+    std::vector<std::vector<double>> points = makeBlobs(config);
+    double eps = 0.6;
+    Metrics::setLogging(false);
+    std::cout << config.points << " points in 512-D, distance kernels: " << (KDTree512::inlineKernel ? "inline fixed-width" : Distance::levelName(Distance::level()))
+              << std::endl;
+
+    std::vector<int> reference;
+    run<KDTree>("KDTree", points, eps, reference);
+    run<ArenaKDTree>("ArenaKDTree", points, eps, reference);
+    run<KDTree512>("KDTree512", points, eps, reference);
+    run<FloatKDTree512>("FloatKDTree512", points, eps, reference);
+    return 0;
+}
@@ -0,0 +1,74 @@
+// Exactness and speed of the NeighborIndex backends on the embeddings
+// main.cpp loads: eps-neighborhood recall against the exact KDTree answer,
+// radius queries per second, and build time.
+#include "KDTree.h"
+#include "ArenaKDTree.h"
+#include "HNSWIndex.h"
+#include "NpyDataset.h"
+#include "BenchUtil.h"
+#include <iostream>
+#include <random>
+#include <numeric>
+#include <unordered_set>
+
+// Mean fraction of the exact eps-neighborhood each backend query returns
+static void report(const std::string& name, NeighborIndex& index, double buildSeconds, const std::vector<int>& queries,
+                   const std::vector<std::vector<int>>& exact, double eps) {
+    std::vector<int> ids;
+    double recallSum = 0.0;
+    size_t found = 0;
+    double querySeconds = secondsFor([&] {
+        for (size_t q = 0; q < queries.size(); ++q) {
+            index.radiusSearchById(queries[q], eps, ids);
+            found += ids.size();
+        }
+    });
+    for (size_t q = 0; q < queries.size(); ++q) {
+        index.radiusSearchById(queries[q], eps, ids);
+        std::unordered_set<int> got(ids.begin(), ids.end());
+        size_t hits = 0;
+        for (int id : exact[q]) hits += got.count(id);
+        recallSum += exact[q].empty() ? 1.0 : static_cast<double>(hits) / exact[q].size();
+    }
+    std::cout << name << ": build " << buildSeconds << " s, " << queries.size() / querySeconds << " queries/s, recall "
+              << recallSum / queries.size() << ", " << found << " neighbors" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::string base_dir = argc > 1 ? argv[1] : "./../python/TESTING_SET/";
+    double eps = argc > 2 ? std::stod(argv[2]) : 1.0;
+    int dimensions = 512;
+
+    std::vector<std::string> labels;
+    std::vector<std::vector<double>> points = convertToDouble(load_npy_files(base_dir, labels));
+    std::cout << "Loaded " << points.size() << " points" << std::endl;
+    if (points.empty()) return 1;
+
+    std::vector<int> queries(std::min<size_t>(1000, points.size()));
+    std::vector<int> order(points.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937 g(42);
+    std::shuffle(order.begin(), order.end(), g);
+    std::copy(order.begin(), order.begin() + queries.size(), queries.begin());
+
+    KDTree kdTree(dimensions);
+    double kdBuild = secondsFor([&] { kdTree.build(points, 0); });
+    std::vector<std::vector<int>> exact(queries.size());
+    for (size_t q = 0; q < queries.size(); ++q) kdTree.radiusSearchById(queries[q], eps, exact[q]);
+    report("KDTree", kdTree, kdBuild, queries, exact, eps);
+
+    ArenaKDTree arenaTree(dimensions);
+    double arenaBuild = secondsFor([&] { arenaTree.build(points, 0); });
+    report("ArenaKDTree", arenaTree, arenaBuild, queries, exact, eps);
+
+    HNSWIndex hnsw(dimensions);
+    double hnswBuild = secondsFor([&] { hnsw.build(points, 0); });
+    for (int ef : {16, 64, 256}) {
+        hnsw.setEfSearch(ef);
+        report("HNSWIndex efSearch=" + std::to_string(ef), hnsw, hnswBuild, queries, exact, eps);
+    }
+    hnsw.setEfSearch(64);
+    hnsw.setRangeExpansion(1.2);
+    report("HNSWIndex efSearch=64 rangeExpansion=1.2", hnsw, hnswBuild, queries, exact, eps);
+    return 0;
+}
@@ -0,0 +1,100 @@
+// Label reads while INCDBSCAN ingests batches of 1000, 10000 and 50000 points.
+// Two reader threads look up the label of a random stored id every 20 us,
+// either through a mutex the writer holds for each batch (the only safe way
+// before LabelSnapshots) or through a pinned LabelSnapshots view, and report
+// read latency percentiles. Only the snapshot reads stay flat as batches grow.
+#include "SyntheticBlobs.h"
+#include "INCDBSCAN.h"
+#include "DBSCAN.h"
+#include "LabelSnapshots.h"
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <random>
+#include <atomic>
+
+struct Latencies {
+    double p50, p99, max;
+    size_t reads;
+};
+
+static Latencies summarize(std::vector<double>& nanoseconds) {
+    std::sort(nanoseconds.begin(), nanoseconds.end());
+    size_t n = nanoseconds.size();
+    return {nanoseconds[n / 2], nanoseconds[n * 99 / 100], nanoseconds.back(), n};
+}
+
+//Ingest the second half of points in batches while readers run read(g) against ids of the first half
+template <typename Read>
+static Latencies run(const std::vector<std::vector<double>>& points, size_t batch, bool snapshot, Read read) {
+    int dimensions = static_cast<int>(points[0].size());
+    size_t half = points.size() / 2;
+    KDTree tree(dimensions);
+    int nextClusterId = 0;
+    DBSCAN dbscan(0.2, 5, tree, nextClusterId);
+    dbscan.cluster(std::vector<std::vector<double>>(points.begin(), points.begin() + half));
+    LabelSnapshots snapshots;
+    snapshots.publish(tree);
+    std::mutex lock;
+    INCDBSCAN incdbscan(0.2, 5, tree);
+    if (snapshot) incdbscan.publishTo(&snapshots);
+
+    std::atomic<bool> done{false};
+    std::vector<std::vector<double>> samples(2);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r) {
+        readers.emplace_back([&, r] {
+            std::mt19937 g(r);
+            std::uniform_int_distribution<int> id(0, static_cast<int>(half) - 1);
+            LabelSnapshots::Reader reader(snapshots);
+            int sink = 0;
+            //Reads are due every 20 us and timed from when they were due, so a stalled reader counts every read it owes
+            auto due = std::chrono::steady_clock::now();
+            while (!done.load(std::memory_order_relaxed)) {
+                due += std::chrono::microseconds(20);
+                while (std::chrono::steady_clock::now() < due) {
+                }
+                sink += read(reader, tree, lock, id(g));
+                auto end = std::chrono::steady_clock::now();
+                samples[r].push_back(std::chrono::duration<double, std::nano>(end - due).count());
+            }
+            if (sink == 42) std::cout << "";
+        });
+    }
+    for (size_t first = half; first < points.size(); first += batch) {
+        std::vector<std::vector<double>> next(points.begin() + first, points.begin() + std::min(points.size(), first + batch));
+        std::unique_lock<std::mutex> guard(lock, std::defer_lock);
+        if (!snapshot) guard.lock();
+        incdbscan.cluster(next, nextClusterId, static_cast<int>(first));
+        incdbscan.getLastClusterId(nextClusterId);
+    }
+    done = true;
+    for (auto& reader : readers) reader.join();
+    samples[0].insert(samples[0].end(), samples[1].begin(), samples[1].end());
+    return summarize(samples[0]);
+}
+
+int main(int argc, char** argv) {
+    BlobConfig config;
+    config.points = argc > 1 ? std::stoul(argv[1]) : 100000;
+    std::vector<std::vector<double>> points = makeBlobs(config);
+    Metrics::setLogging(false);
+
+    auto locked = [](LabelSnapshots::Reader&, KDTree& tree, std::mutex& lock, int id) {
+        std::lock_guard<std::mutex> guard(lock);
+        return tree.getClusterIdById(id);
+    };
+    auto pinned = [](LabelSnapshots::Reader& reader, KDTree&, std::mutex&, int id) {
+        LabelSnapshots::View view = reader.pin();
+        return view.label(id);
+    };
+    for (size_t batch : {1000, 10000, 50000}) {
+        for (bool snapshot : {false, true}) {
+            Latencies l = snapshot ? run(points, batch, true, pinned) : run(points, batch, false, locked);
+            std::cout << "batch " << batch << (snapshot ? ", snapshot reads: " : ", mutex reads:    ") << "p50 " << l.p50 / 1e3 << " us, p99 " << l.p99 / 1e3
+                      << " us, max " << l.max / 1e3 << " us over " << l.reads << " reads" << std::endl;
+        }
+    }
+    return 0;
+}
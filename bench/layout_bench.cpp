@@ -0,0 +1,94 @@
+// Memory-per-point and query-throughput comparison between the shared_ptr
+// KDTree and the arena-backed ArenaKDTree on the embeddings main.cpp loads.
+#include "KDTree.h"
+#include "ArenaKDTree.h"
+#include "NpyDataset.h"
+#include "BenchUtil.h"
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <numeric>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+// Heap bytes in use (glibc), falling back to the resident set size
+static size_t residentBytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmRSS:", 0) == 0) {
+            return std::stoul(line.substr(6)) * 1024;
+        }
+    }
+    return 0;
+#endif
+}
+
+int main(int argc, char** argv) {
+    std::string base_dir = argc > 1 ? argv[1] : "./../python/TESTING_SET/";
+    double eps = argc > 2 ? std::stod(argv[2]) : 1.0;
+    int dimensions = 512;
+
+    std::vector<std::string> labels;
+    std::vector<std::vector<double>> points = convertToDouble(load_npy_files(base_dir, labels));
+    std::cout << "Loaded " << points.size() << " points" << std::endl;
+    if (points.empty()) return 1;
+
+    std::vector<size_t> order(points.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937 g(42);
+    std::shuffle(order.begin(), order.end(), g);
+    size_t queryCount = std::min<size_t>(1000, points.size());
+
+    // Build both layouts with the same insertion order
+    size_t rssBefore = residentBytes();
+    KDTree kdTree(dimensions);
+    double kdBuild = secondsFor([&] {
+        for (size_t i = 0; i < order.size(); ++i) kdTree.insert(points[order[i]], i);
+    });
+    size_t kdRss = residentBytes() - rssBefore;
+
+    rssBefore = residentBytes();
+    ArenaKDTree arenaTree(dimensions);
+    double arenaBuild = secondsFor([&] {
+        arenaTree.reserve(order.size());
+        for (size_t i = 0; i < order.size(); ++i) arenaTree.insert(points[order[i]], i);
+    });
+    size_t arenaRss = residentBytes() - rssBefore;
+
+    size_t n = points.size();
+    std::cout << "KDTree      build " << kdBuild << " s, " << kdTree.memoryUsage() / n << " B/point (structural), "
+              << kdRss / n << " B/point (heap delta)" << std::endl;
+    std::cout << "ArenaKDTree build " << arenaBuild << " s, " << arenaTree.memoryUsage() / n << " B/point (structural), "
+              << arenaRss / n << " B/point (heap delta)" << std::endl;
+
+    // Query throughput over the same query set
+    size_t kdFound = 0, arenaFound = 0, arenaIdFound = 0;
+    double kdQuery = secondsFor([&] {
+        for (size_t q = 0; q < queryCount; ++q) kdFound += kdTree.radiusSearch(points[order[q]], eps).size();
+    });
+    double arenaQuery = secondsFor([&] {
+        for (size_t q = 0; q < queryCount; ++q) arenaFound += arenaTree.radiusSearch(points[order[q]], eps).size();
+    });
+    std::vector<int> ids;
+    double arenaIdQuery = secondsFor([&] {
+        for (size_t q = 0; q < queryCount; ++q) {
+            arenaTree.radiusSearchIds(points[order[q]], eps, ids);
+            arenaIdFound += ids.size();
+        }
+    });
+
+    std::cout << "KDTree::radiusSearch           " << queryCount / kdQuery << " queries/s (" << kdFound << " neighbors)" << std::endl;
+    std::cout << "ArenaKDTree::radiusSearch      " << queryCount / arenaQuery << " queries/s (" << arenaFound << " neighbors)" << std::endl;
+    std::cout << "ArenaKDTree::radiusSearchIds   " << queryCount / arenaIdQuery << " queries/s (" << arenaIdFound << " neighbors)" << std::endl;
+    if (kdFound != arenaFound || kdFound != arenaIdFound) {
+        std::cout << "Neighbor counts differ between layouts" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+// Load time of the embeddings main.cpp reads: the directory tree into one
+// NpyDataset with one thread and with every hardware thread, the row-per-vector
+// load_npy_files form, and the same matrix saved as a single .npy and as a raw
+// float32 file, both mapped back. Every path must produce identical rows.
+#include "NpyDataset.h"
+#include "BenchUtil.h"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+
+static bool sameRows(const NpyDataset& a, const NpyDataset& b) {
+    return a.size() == b.size() && a.dimensions() == b.dimensions() &&
+           std::memcmp(a.data(), b.data(), a.size() * a.dimensions() * sizeof(float)) == 0;
+}
+
+int main(int argc, char** argv) {
+    std::string base_dir = argc > 1 ? argv[1] : "./../python/TESTING_SET/";
+    std::string npyPath = "load_bench.npy";
+    std::string rawPath = "load_bench.f32";
+
+    NpyDataset reference;
+    for (int threads : {1, 0}) {
+        double seconds = secondsFor([&] { reference = NpyDataset::fromDirectory(base_dir, threads); });
+        std::cout << "Directory, " << (threads ? "1 thread" : "all threads") << ": " << seconds << " s for " << reference.size() << " rows of "
+                  << reference.dimensions() << ", " << reference.labelCount() << " labels" << std::endl;
+    }
+
+    std::vector<std::string> labels;
+    std::vector<std::vector<double>> points;
+    double vectorSeconds = secondsFor([&] { points = convertToDouble(load_npy_files(base_dir, labels)); });
+    double doubleSeconds = secondsFor([&] { points = reference.toDouble(); });
+    std::cout << "load_npy_files + convertToDouble: " << vectorSeconds << " s, NpyDataset::toDouble alone: " << doubleSeconds << " s" << std::endl;
+
+    reference.save(npyPath);
+    std::FILE* raw = std::fopen(rawPath.c_str(), "wb");
+    std::fwrite(reference.data(), sizeof(float), reference.size() * reference.dimensions(), raw);
+    std::fclose(raw);
+
+    NpyDataset single;
+    double npySeconds = secondsFor([&] { single = NpyDataset::fromNpyFile(npyPath); });
+    bool npySame = sameRows(single, reference);
+    double rawSeconds = secondsFor([&] { single = NpyDataset::fromRawFile(rawPath, reference.dimensions()); });
+    bool rawSame = sameRows(single, reference);
+    std::cout << "Single .npy mapped: " << npySeconds << " s (" << (npySame ? "identical" : "DIFFERENT") << "), raw float32 mapped: "
+              << rawSeconds << " s (" << (rawSame ? "identical" : "DIFFERENT") << ")" << std::endl;
+    std::remove(npyPath.c_str());
+    std::remove(rawPath.c_str());
+    return 0;
+}
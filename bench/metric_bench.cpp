@@ -0,0 +1,68 @@
+// Cosine search the old way (normalize upstream, KDTree with the L2 radius
+// sqrt(2 eps)) against CosineKDTree with eps itself, on seeded Gaussian blobs.
+// Both must return the same neighborhoods. Then DBSCAN under each metric
+// policy on the same points, with the radius converted for each.
+#include "SyntheticBlobs.h"
+#include "KDTree.h"
+#include "DBSCAN.h"
+#include "BenchUtil.h"
+#include <iostream>
+#include <cmath>
+
+template <typename Tree>
+static void clusterWith(const char* name, const std::vector<std::vector<double>>& points, double eps) {
+    Tree tree(static_cast<int>(points[0].size()));
+    int clusters = 0;
+    std::vector<int> labels;
+    double seconds = secondsFor([&] {
+        DBSCAN dbscan(eps, 5, tree, clusters);
+        dbscan.cluster(points);
+        dbscan.getClustersLabels(labels, clusters);
+    });
+    std::cout << name << " DBSCAN (eps " << eps << "): " << seconds << " s, " << clusters << " clusters" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    BlobConfig config;
+    config.points = argc > 1 ? std::stoul(argv[1]) : 20000;
+    config.dimensions = argc > 2 ? std::stoi(argv[2]) : 64;
+    std::vector<std::vector<double>> points = makeBlobs(config);
+    double eps = 0.01;
+    Metrics::setLogging(false);
+
+    std::vector<std::vector<double>> normalized = points;
+    for (auto& p : normalized) CosineMetric::prepare(p);
+    KDTree euclidean(config.dimensions);
+    CosineKDTree cosine(config.dimensions);
+    euclidean.build(normalized, 0);
+    cosine.build(points, 0);
+
+    size_t n = points.size();
+    std::vector<int> a, b;
+    size_t found = 0, mismatches = 0;
+    double l2Seconds = secondsFor([&] {
+        for (size_t i = 0; i < n; ++i) {
+            euclidean.radiusSearchById(static_cast<int>(i), std::sqrt(2.0 * eps), a);
+            found += a.size();
+        }
+    });
+    double cosineSeconds = secondsFor([&] {
+        for (size_t i = 0; i < n; ++i) cosine.radiusSearchIds(points[i], eps, b);
+    });
+    for (size_t i = 0; i < n; ++i) {
+        cosine.radiusSearchById(static_cast<int>(i), eps, b);
+        euclidean.radiusSearchById(static_cast<int>(i), std::sqrt(2.0 * eps), a);
+        std::sort(a.begin(), a.end());
+        std::sort(b.begin(), b.end());
+        mismatches += a != b;
+    }
+    std::cout << n << " queries in " << config.dimensions << "-D, " << found / n << " neighbors each" << std::endl;
+    std::cout << "Normalized + KDTree (L2) by id: " << l2Seconds << " s, CosineKDTree on raw vectors: " << cosineSeconds << " s, "
+              << mismatches << " neighborhoods differ" << std::endl;
+
+    clusterWith<KDTree>("KDTree on normalized", normalized, std::sqrt(2.0 * eps));
+    clusterWith<SquaredEuclideanKDTree>("SquaredEuclideanKDTree on normalized", normalized, 2.0 * eps);
+    clusterWith<CosineKDTree>("CosineKDTree", points, eps);
+    clusterWith<InnerProductKDTree>("InnerProductKDTree on normalized", normalized, eps);
+    return 0;
+}
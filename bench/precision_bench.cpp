@@ -0,0 +1,70 @@
+// Memory and speed of CompactKDTree at each storage precision against the
+// double ArenaKDTree, on the embeddings main.cpp loads: bytes per point (and
+// per million 512-D points), queries per second, exact re-checks, and whether
+// neighborhoods and DBSCAN labels match the double tree.
+#include "ArenaKDTree.h"
+#include "CompactKDTree.h"
+#include "DBSCAN.h"
+#include "NpyDataset.h"
+#include "BenchUtil.h"
+#include <iostream>
+#include <algorithm>
+
+int main(int argc, char** argv) {
+    std::string base_dir = argc > 1 ? argv[1] : "./../python/TESTING_SET/";
+    double eps = argc > 2 ? std::stod(argv[2]) : 1.0;
+    int minPts = 5;
+    int dimensions = 512;
+
+    std::vector<std::string> labels;
+    std::vector<std::vector<double>> points = convertToDouble(load_npy_files(base_dir, labels));
+    std::cout << "Loaded " << points.size() << " points" << std::endl;
+    if (points.empty()) return 1;
+    size_t n = points.size();
+
+    ArenaKDTree reference(dimensions);
+    reference.build(points, 0);
+    std::vector<std::vector<int>> expected(n);
+    double referenceSeconds = secondsFor([&] {
+        for (size_t i = 0; i < n; ++i) reference.radiusSearchById(static_cast<int>(i), eps, expected[i]);
+    });
+    for (auto& ids : expected) std::sort(ids.begin(), ids.end());
+    std::cout << "ArenaKDTree double: " << reference.memoryUsage() / n << " bytes/point, "
+              << reference.memoryUsage() / n * 1e6 / (1 << 20) << " MiB per million, " << n / referenceSeconds << " queries/s" << std::endl;
+
+    int referenceClusters = 0;
+    std::vector<int> referenceLabels;
+    {
+        ArenaKDTree tree(dimensions);
+        DBSCAN dbscan(eps, minPts, tree, referenceClusters);
+        dbscan.cluster(points);
+        dbscan.getClustersLabels(referenceLabels, referenceClusters);
+    }
+
+    for (auto precision : {CompactKDTree::Precision::Float32, CompactKDTree::Precision::Float16, CompactKDTree::Precision::Int8}) {
+        CompactKDTree tree(dimensions, precision);
+        tree.build(points, 0);
+        std::vector<int> ids;
+        int mismatches = 0;
+        double seconds = secondsFor([&] {
+            for (size_t i = 0; i < n; ++i) {
+                tree.radiusSearchById(static_cast<int>(i), eps, ids);
+                std::sort(ids.begin(), ids.end());
+                mismatches += ids != expected[i];
+            }
+        });
+
+        int clusters = 0;
+        std::vector<int> clusterLabels;
+        CompactKDTree clusterTree(dimensions, precision);
+        DBSCAN dbscan(eps, minPts, clusterTree, clusters);
+        dbscan.cluster(points);
+        dbscan.getClustersLabels(clusterLabels, clusters);
+
+        std::cout << "CompactKDTree " << CompactPointStore::precisionName(precision) << ": " << tree.memoryUsage() / n << " bytes/point, "
+                  << tree.memoryUsage() / n * 1e6 / (1 << 20) << " MiB per million, " << n / seconds << " queries/s, "
+                  << tree.exactChecks() << " exact re-checks, " << mismatches << " mismatching neighborhoods, labels "
+                  << (clusterLabels == referenceLabels ? "identical" : "DIFFERENT") << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+// INCDBSCAN::predict on seeded Gaussian blobs: n points (default 1M) are
+// clustered, then 10000 held-out points from the same blobs are labeled
+// without being inserted. Reports single-query latency percentiles and the
+// throughput of the batched call on one thread and on every hardware thread,
+// on KDTree and on ArenaKDTree.
+#include "SyntheticBlobs.h"
+#include "INCDBSCAN.h"
+#include "DBSCAN.h"
+#include "ArenaKDTree.h"
+#include "BenchUtil.h"
+#include <iostream>
+
+static void run(const char* name, NeighborIndex& tree, const std::vector<std::vector<double>>& points, const std::vector<std::vector<double>>& held, int dimensions) {
+    double eps = 0.2;
+    size_t queries = held.size();
+    int nextClusterId = 0;
+    double clusterSeconds = secondsFor([&] {
+        DBSCAN dbscan(eps, 5, tree, nextClusterId);
+        dbscan.cluster(points);
+    });
+    INCDBSCAN incdbscan(eps, 5, tree);
+    std::cout << name << ": " << points.size() << " points in " << dimensions << "-D clustered in " << clusterSeconds << " s" << std::endl;
+
+    std::vector<double> micros(queries);
+    int labeled = 0;
+    for (size_t q = 0; q < queries; ++q) {
+        INCDBSCAN::Assignment assignment;
+        micros[q] = secondsFor([&] { assignment = incdbscan.predict(held[q]); }) * 1e6;
+        labeled += assignment.label >= 0;
+    }
+    std::sort(micros.begin(), micros.end());
+    std::cout << name << " predict: p50 " << micros[queries / 2] << " us, p99 " << micros[queries * 99 / 100] << " us, max " << micros.back() << " us, "
+              << labeled << " of " << queries << " labeled" << std::endl;
+
+    std::vector<INCDBSCAN::Assignment> assignments;
+    for (int threads : {1, 0}) {
+        double seconds = secondsFor([&] { incdbscan.predict(held, assignments, threads); });
+        std::cout << name << " batched predict on " << resolveThreadCount(threads) << " threads: " << queries / seconds << " queries/s" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    size_t queries = 10000;
+    BlobConfig config;
+    config.points = n + queries;
+    config.dimensions = argc > 2 ? std::stoi(argv[2]) : 16;
+    std::vector<std::vector<double>> points = makeBlobs(config);
+    std::vector<std::vector<double>> held(points.begin() + n, points.end());
+    points.resize(n);
+    Metrics::setLogging(false);
+
+    {
+        KDTree tree(config.dimensions);
+        run("KDTree", tree, points, held, config.dimensions);
+    }
+    ArenaKDTree arena(config.dimensions);
+    arena.reserve(n);
+    run("ArenaKDTree", arena, points, held, config.dimensions);
+    return 0;
+}
@@ -0,0 +1,76 @@
+// Seeded Gaussian blobs clustered in batches by one INCDBSCAN and by
+// ShardedINCDBSCAN with 1, 2, 4 and 8 shards (threads over LocalTransport).
+// Reports time, halo copies per point, and how the sharded labels compare
+// with the single-process ones: a point labeled in only one run, or whose
+// cluster does not map one-to-one between the runs, is a disagreement.
+#include "SyntheticBlobs.h"
+#include "ShardedINCDBSCAN.h"
+#include "BenchUtil.h"
+#include <iostream>
+#include <map>
+
+//Points labeled in only one of the two labelings, or whose cluster does not map one-to-one
+static int disagreements(const std::vector<int>& a, const std::vector<int>& b) {
+    std::map<int, int> forward, backward;
+    int bad = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if ((a[i] < 0) != (b[i] < 0)) {
+            ++bad;
+            continue;
+        }
+        if (a[i] < 0) continue;
+        bad += forward.emplace(a[i], b[i]).first->second != b[i];
+        bad += backward.emplace(b[i], a[i]).first->second != a[i];
+    }
+    return bad;
+}
+
+static int labeled(const std::vector<int>& labels) {
+    int count = 0;
+    for (int label : labels) count += label >= 0;
+    return count;
+}
+
+int main(int argc, char** argv) {
+    BlobConfig config;
+    config.points = argc > 1 ? std::stoul(argv[1]) : 100000;
+    config.dimensions = argc > 2 ? std::stoi(argv[2]) : 16;
+    size_t batch = argc > 3 ? std::stoul(argv[3]) : 10000;
+    double eps = 0.2;
+    int minPts = 5;
+    std::vector<std::vector<double>> points = makeBlobs(config);
+    std::vector<std::vector<std::vector<double>>> batches;
+    for (size_t first = 0; first < points.size(); first += batch) {
+        batches.emplace_back(points.begin() + first, points.begin() + std::min(points.size(), first + batch));
+    }
+    Metrics::setLogging(false);
+
+    KDTree tree(config.dimensions);
+    std::vector<int> reference;
+    double seconds = secondsFor([&] {
+        INCDBSCAN incdbscan(eps, minPts, tree);
+        int nextClusterId = 0, startingIndex = 0;
+        for (const auto& points : batches) {
+            incdbscan.cluster(points, nextClusterId, startingIndex);
+            incdbscan.getLastClusterId(nextClusterId);
+            startingIndex += points.size();
+        }
+        tree.clusterLabels(reference);
+    });
+    std::cout << config.points << " points in " << config.dimensions << "-D, batches of " << batch << std::endl;
+    std::cout << "INCDBSCAN: " << seconds << " s, " << labeled(reference) << " labeled" << std::endl;
+
+    for (int shards : {1, 2, 4, 8}) {
+        std::vector<int> labels;
+        int halo = 0;
+        double seconds = secondsFor([&] {
+            ShardedINCDBSCAN sharded(eps, minPts, config.dimensions, shards);
+            for (const auto& points : batches) sharded.cluster(points);
+            sharded.clusterLabels(labels);
+            for (const auto& stats : sharded.shardStats()) halo += stats.halo;
+        });
+        std::cout << shards << " shards: " << seconds << " s, " << static_cast<double>(halo) / config.points << " halo copies per point, "
+                  << labeled(labels) << " labeled, " << disagreements(labels, reference) << " disagreements" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,96 @@
+// Cold start against warm restart on the embeddings main.cpp loads: clusters
+// the first three quarters with DBSCAN on an ArenaKDTree, saves a Snapshot and
+// loads it back (with and without checksum verification), checks that the
+// restored tree answers every query and holds every per-point state exactly as
+// the original, then feeds the last quarter to INCDBSCAN on both trees and
+// compares the labels.
+#include "ArenaKDTree.h"
+#include "Snapshot.h"
+#include "DBSCAN.h"
+#include "INCDBSCAN.h"
+#include "NpyDataset.h"
+#include "BenchUtil.h"
+#include <iostream>
+#include <cstdio>
+#include <algorithm>
+
+static std::vector<int> labelsOf(const NeighborIndex& index, int count) {
+    std::vector<int> labels(count);
+    for (int id = 0; id < count; ++id) labels[id] = index.getClusterIdById(id);
+    return labels;
+}
+
+int main(int argc, char** argv) {
+    std::string base_dir = argc > 1 ? argv[1] : "./../python/TESTING_SET/";
+    double eps = argc > 2 ? std::stod(argv[2]) : 1.0;
+    std::string path = argc > 3 ? argv[3] : "snapshot_bench.snap";
+    int minPts = 5;
+    int dimensions = 512;
+
+    std::vector<std::string> labels;
+    std::vector<std::vector<double>> points = convertToDouble(load_npy_files(base_dir, labels));
+    std::cout << "Loaded " << points.size() << " points" << std::endl;
+    if (points.size() < 4) return 1;
+    int initial = static_cast<int>(points.size() * 3 / 4);
+    std::vector<std::vector<double>> head(points.begin(), points.begin() + initial);
+    std::vector<std::vector<double>> tail(points.begin() + initial, points.end());
+
+    ArenaKDTree original(dimensions);
+    int nextClusterId = 0;
+    double coldSeconds = secondsFor([&] {
+        DBSCAN dbscan(eps, minPts, original, nextClusterId);
+        dbscan.cluster(head);
+        std::vector<int> ignored;
+        dbscan.getClustersLabels(ignored, nextClusterId);
+    });
+    std::cout << "Cold start (build + DBSCAN) of " << initial << " points: " << coldSeconds << " s" << std::endl;
+
+    double saveSeconds = secondsFor([&] { Snapshot::save(original, nextClusterId, path); });
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    std::fseek(file, 0, SEEK_END);
+    long bytes = std::ftell(file);
+    std::fclose(file);
+    std::cout << "Snapshot save: " << saveSeconds << " s, " << bytes / double(1 << 20) << " MiB" << std::endl;
+
+    for (bool verify : {true, false}) {
+        ArenaKDTree restored(dimensions);
+        int restoredNext = 0;
+        double loadSeconds = secondsFor([&] { restoredNext = Snapshot::load(restored, path, verify); });
+
+        //Every neighborhood and every piece of per-point state must come back unchanged
+        int mismatches = 0;
+        std::vector<int> expected, found;
+        double querySeconds = secondsFor([&] {
+            for (int id = 0; id < initial; ++id) {
+                original.radiusSearchById(id, eps, expected);
+                restored.radiusSearchById(id, eps, found);
+                std::sort(expected.begin(), expected.end());
+                std::sort(found.begin(), found.end());
+                mismatches += expected != found;
+            }
+        });
+        std::vector<int> clustersA, clustersB, countsA, countsB;
+        std::vector<char> visitedA, visitedB;
+        double radiusA, radiusB;
+        original.exportPointState(clustersA, visitedA, countsA, radiusA);
+        restored.exportPointState(clustersB, visitedB, countsB, radiusB);
+        bool sameState = clustersA == clustersB && visitedA == visitedB && countsA == countsB && radiusA == radiusB && restoredNext == nextClusterId;
+        std::cout << "Snapshot load" << (verify ? " (verified)" : " (unverified)") << ": " << loadSeconds << " s, first pass over "
+                  << initial << " queries " << querySeconds << " s, " << mismatches << " mismatching neighborhoods, state "
+                  << (sameState ? "identical" : "DIFFERENT") << std::endl;
+        if (verify) continue;
+
+        //Keep clustering from the restored state; the first insert copies the mapping into memory
+        ArenaKDTree continued(dimensions);
+        Snapshot::load(continued, path);
+        INCDBSCAN fromOriginal(eps, minPts, original);
+        fromOriginal.cluster(tail, nextClusterId, initial);
+        INCDBSCAN fromSnapshot(eps, minPts, continued);
+        fromSnapshot.cluster(tail, restoredNext, initial);
+        int total = static_cast<int>(points.size());
+        std::cout << "INCDBSCAN after restore: labels " << (labelsOf(original, total) == labelsOf(continued, total) ? "identical" : "DIFFERENT")
+                  << ", restored tree " << (continued.isMapped() ? "still mapped" : "copied into memory") << std::endl;
+    }
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,76 @@
+// Streaming ingestion of the embeddings main.cpp loads: producer threads push
+// points at a fixed total rate (0 = as fast as they can) into a
+// StreamingINCDBSCAN over an ArenaKDTree, and the run reports batch sizes,
+// push-to-label latency percentiles, throughput and how often producers had
+// to wait for room in the queue.
+#include "ArenaKDTree.h"
+#include "INCDBSCAN.h"
+#include "StreamingINCDBSCAN.h"
+#include "NpyDataset.h"
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <algorithm>
+
+int main(int argc, char** argv) {
+    std::string base_dir = argc > 1 ? argv[1] : "./../python/TESTING_SET/";
+    double eps = argc > 2 ? std::stod(argv[2]) : 1.0;
+    double targetLatency = argc > 3 ? std::stod(argv[3]) : 0.5;
+    double pointsPerSecond = argc > 4 ? std::stod(argv[4]) : 2000.0;
+    int producers = argc > 5 ? std::stoi(argv[5]) : 4;
+    size_t queueCapacity = argc > 6 ? std::stoul(argv[6]) : 1024;
+    int minPts = 5;
+    int dimensions = 512;
+
+    std::vector<std::string> labels;
+    std::vector<std::vector<double>> points = convertToDouble(load_npy_files(base_dir, labels));
+    std::cout << "Loaded " << points.size() << " points" << std::endl;
+    if (points.empty()) return 1;
+
+    ArenaKDTree tree(dimensions);
+    INCDBSCAN incdbscan(eps, minPts, tree);
+    StreamingINCDBSCAN stream(incdbscan, queueCapacity, targetLatency);
+    std::mutex reportsMutex;
+    std::vector<StreamingINCDBSCAN::BatchReport> reports;
+    stream.setBatchCallback([&](const StreamingINCDBSCAN::BatchReport& report) {
+        std::lock_guard<std::mutex> lock(reportsMutex);
+        reports.push_back(report);
+    });
+    stream.start();
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            //Producer p sends points p, p + producers, ... on its share of the rate
+            double interval = pointsPerSecond > 0.0 ? producers / pointsPerSecond : 0.0;
+            auto next = std::chrono::steady_clock::now();
+            for (size_t i = p; i < points.size(); i += producers) {
+                if (interval > 0.0) {
+                    next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(interval));
+                    std::this_thread::sleep_until(next);
+                }
+                stream.push(points[i]);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    stream.finish();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> latencies;
+    size_t largest = 0;
+    for (const auto& report : reports) {
+        latencies.push_back(report.latencySeconds);
+        largest = std::max<size_t>(largest, report.size);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double q) { return latencies[std::min(latencies.size() - 1, static_cast<size_t>(q * latencies.size()))]; };
+    std::cout << "Streamed " << tree.size() << " points in " << seconds << " s (" << tree.size() / seconds << " points/s), "
+              << reports.size() << " batches, largest " << largest << std::endl;
+    std::cout << "Batch latency p50 " << percentile(0.5) << " s, p95 " << percentile(0.95) << " s, max " << latencies.back()
+              << " s against a " << targetLatency << " s target" << std::endl;
+    std::cout << "Producer waits on a full queue: " << stream.backpressureWaits() << ", clusters handed out: " << stream.lastClusterId() << std::endl;
+    return 0;
+}
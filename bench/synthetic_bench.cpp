@@ -0,0 +1,190 @@
+// Scaling benchmark on seeded Gaussian blobs (SyntheticBlobs.h), independent
+// of any dataset on disk: index build, radius-query latency percentiles, a
+// full DBSCAN::cluster, and INCDBSCAN::cluster throughput when the second half
+// of the points arrives in batches of each requested size. Results go out as
+// one JSON object (stdout, or out=<path>); the algorithms' own logging is
+// switched off. Built with -DINCDBSCAN_METRICS=1 the object also carries the
+// Metrics counters and histograms, and trace=<path> writes a Chrome trace.
+//
+// Options are key=value: n, dims, clusters, noise, sigma, spread, seed, eps,
+// minPts, queries, batches (comma separated), backend (arena, kd or brute), out,
+// trace.
+#include "SyntheticBlobs.h"
+#include "KDTree.h"
+#include "ArenaKDTree.h"
+#include "BruteForceEngine.h"
+#include "DBSCAN.h"
+#include "INCDBSCAN.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <memory>
+#include <map>
+#include <algorithm>
+
+using Clock = std::chrono::steady_clock;
+
+static double since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static std::unique_ptr<NeighborIndex> makeIndex(const std::string& backend, int dimensions) {
+    if (backend == "kd") return std::make_unique<KDTree>(dimensions);
+    if (backend == "brute") return std::make_unique<BruteForceEngine>(dimensions);
+    return std::make_unique<ArenaKDTree>(dimensions);
+}
+
+//Value at quantile q of sorted samples
+static double quantile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) return 0.0;
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(q * sorted.size()))];
+}
+
+static std::string percentiles(std::vector<double> samples, double scale) {
+    std::sort(samples.begin(), samples.end());
+    std::ostringstream out;
+    out << "{\"p50\": " << quantile(samples, 0.5) * scale << ", \"p90\": " << quantile(samples, 0.9) * scale
+        << ", \"p99\": " << quantile(samples, 0.99) * scale << ", \"max\": " << (samples.empty() ? 0.0 : samples.back() * scale) << "}";
+    return out.str();
+}
+
+int main(int argc, char** argv) {
+    std::map<std::string, std::string> options;
+    for (int a = 1; a < argc; ++a) {
+        std::string arg = argv[a];
+        size_t eq = arg.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "expected key=value, got " << arg << std::endl;
+            return 1;
+        }
+        options[arg.substr(0, eq)] = arg.substr(eq + 1);
+    }
+    auto option = [&](const std::string& key, const std::string& fallback) {
+        auto it = options.find(key);
+        return it == options.end() ? fallback : it->second;
+    };
+
+    BlobConfig config;
+    config.points = std::stoul(option("n", "100000"));
+    config.dimensions = std::stoi(option("dims", "16"));
+    config.clusters = std::stoi(option("clusters", "20"));
+    config.noise = std::stod(option("noise", "0.05"));
+    config.sigma = std::stod(option("sigma", "0.05"));
+    config.spread = std::stod(option("spread", "1.0"));
+    config.seed = static_cast<unsigned>(std::stoul(option("seed", "42")));
+    double eps = std::stod(option("eps", "0.2"));
+    int minPts = std::stoi(option("minPts", "5"));
+    size_t queryCount = std::stoul(option("queries", "1000"));
+    std::string backend = option("backend", "arena");
+    std::vector<size_t> batchSizes;
+    {
+        std::stringstream list(option("batches", "100,1000,10000"));
+        std::string item;
+        while (std::getline(list, item, ',')) {
+            if (!item.empty()) batchSizes.push_back(std::stoul(item));
+        }
+    }
+
+    Metrics::setLogging(false);
+    std::string trace = option("trace", "");
+    if (!trace.empty()) Metrics::startTrace();
+
+    Clock::time_point start = Clock::now();
+    std::vector<std::vector<double>> points = makeBlobs(config);
+    double generateSeconds = since(start);
+    int n = static_cast<int>(points.size());
+
+    std::ostringstream json;
+    json << "{\n  \"config\": {\"n\": " << n << ", \"dims\": " << config.dimensions << ", \"clusters\": " << config.clusters
+         << ", \"noise\": " << config.noise << ", \"sigma\": " << config.sigma << ", \"spread\": " << config.spread << ", \"seed\": "
+         << config.seed << ", \"eps\": " << eps << ", \"minPts\": " << minPts << ", \"backend\": \"" << backend << "\"},\n";
+    json << "  \"generate_seconds\": " << generateSeconds << ",\n";
+
+    //Build, then per-query latency on a seeded sample of stored points
+    {
+        std::unique_ptr<NeighborIndex> index = makeIndex(backend, config.dimensions);
+        start = Clock::now();
+        index->build(points, 0);
+        double buildSeconds = since(start);
+
+        std::mt19937 g(config.seed + 1);
+        std::uniform_int_distribution<int> pick(0, n - 1);
+        std::vector<double> latencies;
+        std::vector<int> ids;
+        size_t neighbors = 0;
+        for (size_t q = 0; q < queryCount && n > 0; ++q) {
+            int id = pick(g);
+            start = Clock::now();
+            index->radiusSearchById(id, eps, ids);
+            latencies.push_back(since(start));
+            neighbors += ids.size();
+        }
+        json << "  \"build\": {\"seconds\": " << buildSeconds << ", \"points_per_second\": " << n / buildSeconds << "},\n";
+        json << "  \"radius_query\": {\"count\": " << latencies.size() << ", \"mean_neighbors\": "
+             << (latencies.empty() ? 0.0 : static_cast<double>(neighbors) / latencies.size()) << ", \"latency_us\": " << percentiles(latencies, 1e6)
+             << "},\n";
+    }
+
+    //Full DBSCAN from an empty index
+    {
+        std::unique_ptr<NeighborIndex> index = makeIndex(backend, config.dimensions);
+        int clusterCount = 0;
+        std::vector<int> labels;
+        double seconds = 0.0;
+        DBSCAN dbscan(eps, minPts, *index, clusterCount);
+        start = Clock::now();
+        dbscan.cluster(points);
+        seconds = since(start);
+        dbscan.getClustersLabels(labels, clusterCount);
+        size_t noise = std::count(labels.begin(), labels.end(), -1);
+        json << "  \"dbscan\": {\"seconds\": " << seconds << ", \"points_per_second\": " << n / seconds << ", \"clusters\": " << clusterCount
+             << ", \"noise\": " << noise << "},\n";
+    }
+
+    //First half by DBSCAN, second half through INCDBSCAN in batches of each size
+    json << "  \"incdbscan\": [";
+    int initial = n / 2;
+    std::vector<std::vector<double>> head(points.begin(), points.begin() + initial);
+    for (size_t b = 0; b < batchSizes.size(); ++b) {
+        size_t batchSize = std::max<size_t>(1, batchSizes[b]);
+        std::unique_ptr<NeighborIndex> index = makeIndex(backend, config.dimensions);
+        std::vector<double> batchSeconds;
+        double seconds = 0.0;
+        int nextClusterId = 0;
+        DBSCAN dbscan(eps, minPts, *index, nextClusterId);
+        dbscan.cluster(head);
+        std::vector<int> ignored;
+        dbscan.getClustersLabels(ignored, nextClusterId);
+
+        INCDBSCAN incdbscan(eps, minPts, *index);
+        for (size_t first = initial; first < points.size(); first += batchSize) {
+            size_t last = std::min(points.size(), first + batchSize);
+            std::vector<std::vector<double>> batch(points.begin() + first, points.begin() + last);
+            start = Clock::now();
+            incdbscan.cluster(batch, nextClusterId, static_cast<int>(first));
+            batchSeconds.push_back(since(start));
+            seconds += batchSeconds.back();
+            incdbscan.getLastClusterId(nextClusterId);
+        }
+        int inserted = n - initial;
+        json << (b ? ",\n" : "\n") << "    {\"batch_size\": " << batchSize << ", \"batches\": " << batchSeconds.size() << ", \"seconds\": " << seconds
+             << ", \"points_per_second\": " << (seconds > 0.0 ? inserted / seconds : 0.0) << ", \"batch_latency_ms\": " << percentiles(batchSeconds, 1e3)
+             << "}";
+    }
+    json << "\n  ]";
+#if INCDBSCAN_METRICS
+    json << ",\n  \"metrics\": " << Metrics::snapshot().toJson();
+#endif
+    json << "\n}\n";
+    if (!trace.empty() && !Metrics::stopTrace(trace)) std::cerr << "could not write trace to " << trace << std::endl;
+
+    std::string out = option("out", "");
+    if (out.empty()) {
+        std::cout << json.str();
+    } else {
+        std::ofstream file(out);
+        file << json.str();
+    }
+    return 0;
+}
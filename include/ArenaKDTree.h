@@ -0,0 +1,224 @@
+// ArenaKDTree.h
+#ifndef ARENAKDTREE_H
+#define ARENAKDTREE_H
+
+#include "PointArena.h"
+#include "Distance.h"
+#include "NeighborIndex.h"
+#include "MappedFile.h"
+#include "Metrics.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cmath>
+#include <functional>
+
+// KD-tree over a PointArena. Coordinates live in one contiguous buffer indexed
+// by point id and nodes are 16-byte records in a pool linked by position, so
+// inserting a point costs no per-node allocation and traversal touches only
+// the pool and the rows it compares against. Removed points stay in the pool
+// as tombstones that searches skip, so ids must not be reused after removal.
+// A tree loaded from a Snapshot searches the mapped rows and nodes in place;
+// the first insert copies them into memory it owns.
+class ArenaKDTree : public NeighborIndex {
+public:
+    struct Node {
+        int32_t left;
+        int32_t right;
+        int32_t id;
+        int32_t axis;
+    };
+
+    static constexpr int32_t nil = -1;
+
+    ArenaKDTree(int dimensions) : dimensions(dimensions), arena(dimensions), root(nil) {}
+
+    void reserve(size_t n) {
+        if (mapping) thaw();
+        arena.reserve(n);
+        pool.reserve(n);
+    }
+
+    void insert(const std::vector<double>& point, int index) override {
+        if (mapping) thaw();
+        arena.set(index, point);
+        registerId(index);
+        if (index >= static_cast<int>(removed.size())) removed.resize(index + 1, 0);
+        removed[index] = 0;
+        ++live;
+        int32_t slot = static_cast<int32_t>(pool.size());
+        pool.push_back({nil, nil, index, 0});
+
+        if (root == nil) {
+            root = slot;
+            pointInserted(index);
+            return;
+        }
+        const double* p = arena.row(index);
+        int32_t current = root;
+        int depth = 0;
+        while (true) {
+            Node& node = pool[current];
+            int32_t& next = p[node.axis] < arena.row(node.id)[node.axis] ? node.left : node.right;
+            ++depth;
+            if (next == nil) {
+                next = slot;
+                pool[slot].axis = depth % dimensions;
+                pointInserted(index);
+                return;
+            }
+            current = next;
+        }
+    }
+
+    void removeById(int id) override {
+        if (id >= 0 && id < static_cast<int>(removed.size()) && !removed[id]) {
+            pointRemoving(id);
+            removed[id] = 1;
+            --live;
+        }
+    }
+
+    std::vector<std::vector<double>> radiusSearch(const std::vector<double>& target, double radius) const {
+        std::vector<int> ids;
+        radiusSearchIds(target, radius, ids);
+        std::vector<std::vector<double>> results;
+        results.reserve(ids.size());
+        for (int id : ids) {
+            results.push_back(arena.point(id));
+        }
+        return results;
+    }
+
+    //Collect the ids (and optionally squared distances) of all points within radius of target
+    void radiusSearchIds(const std::vector<double>& target, double radius, std::vector<int>& ids, std::vector<double>* sqDistances = nullptr) const override {
+        METRIC_SCOPE(RadiusQuery);
+        METRIC_ADD(RadiusQueries, 1);
+        ids.clear();
+        if (sqDistances) sqDistances->clear();
+        radiusSearchRec(root, target.data(), radius, radius * radius, ids, sqDistances);
+    }
+
+    //Nearest accepted point, searched near side first with the cover shrinking to the best distance found
+    int nearestWithin(const std::vector<double>& target, double radius, const std::function<bool(int)>& accept, double* sqDistance = nullptr) const override {
+        METRIC_SCOPE(RadiusQuery);
+        METRIC_ADD(RadiusQueries, 1);
+        Nearest nearest{-1, radius * radius, radius};
+        if (radius >= 0.0) nearestRec(root, target.data(), accept, nearest);
+        if (nearest.id >= 0 && sqDistance) *sqDistance = nearest.distSq;
+        return nearest.id;
+    }
+
+    //Radius search around a stored point, addressed by id
+    void radiusSearchById(int id, double radius, std::vector<int>& ids, std::vector<double>* sqDistances = nullptr) const override {
+        METRIC_SCOPE(RadiusQuery);
+        METRIC_ADD(RadiusQueries, 1);
+        ids.clear();
+        if (sqDistances) sqDistances->clear();
+        if (id < 0 || id >= static_cast<int>(removed.size()) || removed[id]) return;
+        radiusSearchRec(root, arena.row(id), radius, radius * radius, ids, sqDistances);
+    }
+
+    std::vector<double> getPoint(int id) const override {
+        return arena.point(id);
+    }
+
+    const double* pointData(int id) const {
+        return arena.row(id);
+    }
+
+    int size() const override {
+        return live;
+    }
+
+    //Bytes held by the coordinate arena and the node pool (mapped snapshot pages not included)
+    size_t memoryUsage() const {
+        return arena.memoryUsage() + pool.capacity() * sizeof(Node);
+    }
+
+    //True while rows and nodes are read from a mapped snapshot
+    bool isMapped() const {
+        return mapping != nullptr;
+    }
+
+private:
+    friend class Snapshot;
+
+    int dimensions;
+    PointArena arena;
+    std::vector<Node> pool;
+    std::vector<char> removed;
+    int32_t root;
+    int live = 0;
+    std::shared_ptr<const MappedFile> mapping;
+    const Node* mappedPool = nullptr;
+    size_t mappedNodes = 0;
+
+    const Node& nodeAt(int32_t slot) const {
+        return mappedPool ? mappedPool[slot] : pool[slot];
+    }
+
+    //Copy the mapped rows and nodes into owned memory and drop the mapping
+    void thaw() {
+        pool.assign(mappedPool, mappedPool + mappedNodes);
+        if (!arena.ownsRows()) arena = PointArena(arena);
+        mappedPool = nullptr;
+        mappedNodes = 0;
+        mapping.reset();
+    }
+
+    struct Nearest {
+        int id;
+        double distSq; // best squared distance so far; radius squared until something is accepted
+        double cover;  // its square root, how far from a splitting plane the far side is still searched
+    };
+
+    void nearestRec(int32_t current, const double* target, const std::function<bool(int)>& accept, Nearest& nearest) const {
+        while (current != nil) {
+            const Node& node = nodeAt(current);
+            const double* p = arena.row(node.id);
+            METRIC_ADD(NodesVisited, 1);
+            METRIC_ADD(DistanceEvaluations, 1);
+            double distSq = Distance::squaredBounded(p, target, dimensions, nearest.distSq);
+            bool better = nearest.id < 0 ? distSq <= nearest.distSq : distSq < nearest.distSq || (distSq == nearest.distSq && node.id < nearest.id);
+            if (better && !removed[node.id] && accept(node.id)) {
+                nearest.id = node.id;
+                nearest.distSq = distSq;
+                nearest.cover = std::sqrt(distSq);
+            }
+
+            //Loop on the near side when the cover misses the far one, else recurse into the near side
+            //and loop on the far one if the cover, which may have shrunk meanwhile, still reaches it
+            double offset = target[node.axis] - p[node.axis];
+            int32_t nearSide = offset < 0.0 ? node.left : node.right;
+            int32_t farSide = offset < 0.0 ? node.right : node.left;
+            if (farSide == nil || std::fabs(offset) > nearest.cover) {
+                current = nearSide;
+                continue;
+            }
+            if (nearSide != nil) nearestRec(nearSide, target, accept, nearest);
+            current = std::fabs(offset) <= nearest.cover ? farSide : nil;
+        }
+    }
+
+    void radiusSearchRec(int32_t current, const double* target, double radius, double radiusSq, std::vector<int>& ids, std::vector<double>* sqDistances) const {
+        if (current == nil) return;
+
+        const Node& node = nodeAt(current);
+        const double* p = arena.row(node.id);
+        METRIC_ADD(NodesVisited, 1);
+        METRIC_ADD(DistanceEvaluations, 1);
+        double distSq = Distance::squaredBounded(p, target, dimensions, radiusSq);
+        if (distSq <= radiusSq && !removed[node.id]) {
+            ids.push_back(node.id);
+            if (sqDistances) sqDistances->push_back(distSq);
+        }
+
+        if (target[node.axis] - radius <= p[node.axis])
+            radiusSearchRec(node.left, target, radius, radiusSq, ids, sqDistances);
+        if (target[node.axis] + radius >= p[node.axis])
+            radiusSearchRec(node.right, target, radius, radiusSq, ids, sqDistances);
+    }
+};
+
+#endif
@@ -0,0 +1,290 @@
+// BruteForceEngine.h
+#ifndef BRUTEFORCEENGINE_H
+#define BRUTEFORCEENGINE_H
+
+#include "PointArena.h"
+#include "Distance.h"
+#include "NeighborIndex.h"
+#include "ParallelFor.h"
+#include "Metrics.h"
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+#include <limits>
+
+// Exact neighbor engine that compares every query against every stored point.
+// Batch queries expand the squared distance as |a|² + |b|² - 2a·b and compute
+// the dot products tile by tile, GEMM style: a tile of queries against a tile
+// of stored points, one block of dimensions at a time, with a 4x2 register
+// blocked kernel so every loaded row is reused across several products. Pairs
+// whose expanded distance lands within rounding error of eps² are re-checked
+// with the direct kernel, so the result matches the KD-tree exactly.
+class BruteForceEngine : public NeighborIndex {
+public:
+    explicit BruteForceEngine(int dimensions) : dimensions(dimensions), arena(dimensions) {}
+
+    //Threads used by radiusSearchBatch, 0 for every hardware thread
+    void setNumThreads(int threads) {
+        numThreads = resolveThreadCount(threads);
+    }
+
+    //Queries and stored points per tile, and dimensions per block (rounded up to a multiple of 8)
+    void setTileSizes(int queries, int points, int depth) {
+        queryTile = std::max(4, queries / 4 * 4);
+        pointTile = std::max(2, points / 2 * 2);
+        depthTile = std::max<size_t>(8, (static_cast<size_t>(depth) + 7) / 8 * 8);
+    }
+
+    void reserve(size_t n) {
+        arena.reserve(n);
+    }
+
+    void insert(const std::vector<double>& point, int index) override {
+        store(point, index);
+        pointInserted(index);
+    }
+
+    //Bulk load: store every point, then one batch query records their counts and neighborhoods
+    void build(const std::vector<std::vector<double>>& points, int startIndex = 0) override {
+        for (size_t i = 0; i < points.size(); ++i) {
+            store(points[i], startIndex + static_cast<int>(i));
+        }
+        pointsInserted(startIndex, static_cast<int>(points.size()));
+    }
+
+    void removeById(int id) override {
+        if (id >= 0 && id < static_cast<int>(present.size()) && present[id]) {
+            pointRemoving(id);
+            present[id] = 0;
+            --live;
+        }
+    }
+
+    //Collect the ids (and optionally squared distances) of all points within radius of target
+    void radiusSearchIds(const std::vector<double>& target, double radius, std::vector<int>& ids, std::vector<double>* sqDistances = nullptr) const override {
+        scan(target.data(), radius * radius, ids, sqDistances);
+    }
+
+    //Radius search around a stored point, addressed by id
+    void radiusSearchById(int id, double radius, std::vector<int>& ids, std::vector<double>* sqDistances = nullptr) const override {
+        if (id < 0 || id >= static_cast<int>(present.size()) || !present[id]) {
+            ids.clear();
+            if (sqDistances) sqDistances->clear();
+            return;
+        }
+        scan(arena.row(id), radius * radius, ids, sqDistances);
+    }
+
+    bool batchQueries() const override { return true; }
+
+    void radiusSearchBatch(const std::vector<int>& queryIds, double radius, std::vector<int>& offsets, std::vector<int>& ids) const override {
+        std::vector<int> candidates;
+        candidates.reserve(live);
+        for (int id = 0; id < static_cast<int>(present.size()); ++id) {
+            if (present[id]) candidates.push_back(id);
+        }
+
+        METRIC_ADD(RadiusQueries, queryIds.size());
+        METRIC_ADD(DistanceEvaluations, queryIds.size() * candidates.size());
+        size_t tiles = (queryIds.size() + queryTile - 1) / queryTile;
+        std::vector<std::vector<int>> found(queryIds.size());
+        parallelFor(numThreads, tiles, 1, [&](size_t tile) {
+            searchTile(queryIds, tile * queryTile, candidates, radius * radius, found);
+        });
+
+        offsets.assign(queryIds.size() + 1, 0);
+        for (size_t q = 0; q < queryIds.size(); ++q) offsets[q + 1] = offsets[q] + static_cast<int>(found[q].size());
+        ids.resize(offsets.back());
+        for (size_t q = 0; q < queryIds.size(); ++q) std::copy(found[q].begin(), found[q].end(), ids.begin() + offsets[q]);
+    }
+
+    //Number of queries whose batch neighborhood differs from the reference index's answer
+    int countMismatches(const NeighborIndex& reference, const std::vector<int>& queryIds, double radius) const {
+        std::vector<int> offsets, ids, expected;
+        radiusSearchBatch(queryIds, radius, offsets, ids);
+        int mismatches = 0;
+        for (size_t q = 0; q < queryIds.size(); ++q) {
+            reference.radiusSearchById(queryIds[q], radius, expected);
+            std::unordered_set<int> got(ids.begin() + offsets[q], ids.begin() + offsets[q + 1]);
+            bool same = got.size() == expected.size();
+            for (size_t k = 0; same && k < expected.size(); ++k) same = got.count(expected[k]) != 0;
+            if (!same) ++mismatches;
+        }
+        return mismatches;
+    }
+
+    std::vector<double> getPoint(int id) const override {
+        return arena.point(id);
+    }
+
+    int size() const override {
+        return live;
+    }
+
+    //Bytes held by the coordinate arena and the norms
+    size_t memoryUsage() const {
+        return arena.memoryUsage() + norms.capacity() * sizeof(double) + present.capacity();
+    }
+
+private:
+    //Dot products of 4 rows of a against 2 rows of b over len doubles, written to out[row * 2 + col]
+    using DotKernel = void (*)(const double* const*, const double* const*, size_t, double*);
+
+    int dimensions;
+    PointArena arena;
+    std::vector<double> norms;
+    std::vector<char> present;
+    int live = 0;
+    int numThreads = 1;
+    int queryTile = 32;
+    int pointTile = 256;
+    size_t depthTile = 512;
+
+    void store(const std::vector<double>& point, int index) {
+        arena.set(index, point);
+        registerId(index);
+        if (index >= static_cast<int>(present.size())) {
+            present.resize(index + 1, 0);
+            norms.resize(index + 1, 0.0);
+        }
+        if (!present[index]) ++live;
+        present[index] = 1;
+        const double* p = arena.row(index);
+        double norm = 0.0;
+        for (int k = 0; k < dimensions; ++k) norm += p[k] * p[k];
+        norms[index] = norm;
+    }
+
+    void scan(const double* target, double radiusSq, std::vector<int>& ids, std::vector<double>* sqDistances) const {
+        METRIC_SCOPE(RadiusQuery);
+        METRIC_ADD(RadiusQueries, 1);
+        METRIC_ADD(DistanceEvaluations, live);
+        ids.clear();
+        if (sqDistances) sqDistances->clear();
+        for (int id = 0; id < static_cast<int>(present.size()); ++id) {
+            if (!present[id]) continue;
+            double distSq = Distance::squaredBounded(arena.row(id), target, dimensions, radiusSq);
+            if (distSq <= radiusSq) {
+                ids.push_back(id);
+                if (sqDistances) sqDistances->push_back(distSq);
+            }
+        }
+    }
+
+    //All neighbors of queries [first, first + queryTile) against every candidate, tile by tile
+    void searchTile(const std::vector<int>& queryIds, size_t first, const std::vector<int>& candidates, double radiusSq,
+                    std::vector<std::vector<int>>& found) const {
+        const DotKernel kernel = dotKernel();
+        const size_t stride = arena.rowStride();
+        const int qn = static_cast<int>(std::min<size_t>(queryTile, queryIds.size() - first));
+        const double unit = std::numeric_limits<double>::epsilon();
+        std::vector<double> dots(static_cast<size_t>(queryTile) * pointTile);
+        double out[8];
+
+        for (size_t p0 = 0; p0 < candidates.size(); p0 += pointTile) {
+            const int pn = static_cast<int>(std::min<size_t>(pointTile, candidates.size() - p0));
+            std::fill(dots.begin(), dots.end(), 0.0);
+            //Rows are zero padded to the stride, so blocks may run over it
+            for (size_t k0 = 0; k0 < stride; k0 += depthTile) {
+                const size_t kn = std::min(depthTile, stride - k0);
+                for (int qi = 0; qi < qn; qi += 4) {
+                    const double* a[4];
+                    //A short last group repeats its final row and drops the extra products
+                    for (int r = 0; r < 4; ++r) a[r] = arena.row(queryIds[first + std::min(qi + r, qn - 1)]) + k0;
+                    for (int pi = 0; pi < pn; pi += 2) {
+                        const double* b[2] = {arena.row(candidates[p0 + pi]) + k0,
+                                              arena.row(candidates[p0 + std::min(pi + 1, pn - 1)]) + k0};
+                        kernel(a, b, kn, out);
+                        for (int r = 0; r < 4 && qi + r < qn; ++r) {
+                            for (int c = 0; c < 2 && pi + c < pn; ++c) {
+                                dots[(qi + r) * pointTile + pi + c] += out[r * 2 + c];
+                            }
+                        }
+                    }
+                }
+            }
+
+            for (int qi = 0; qi < qn; ++qi) {
+                int q = queryIds[first + qi];
+                for (int pi = 0; pi < pn; ++pi) {
+                    int p = candidates[p0 + pi];
+                    double distSq = norms[q] + norms[p] - 2.0 * dots[qi * pointTile + pi];
+                    //Bound on the rounding error of the expanded form
+                    double margin = 4.0 * (dimensions + 2) * unit * (norms[q] + norms[p]);
+                    if (distSq > radiusSq + margin) continue;
+                    if (distSq >= radiusSq - margin &&
+                        Distance::squaredBounded(arena.row(p), arena.row(q), dimensions, radiusSq) > radiusSq) continue;
+                    found[first + qi].push_back(p);
+                }
+            }
+        }
+    }
+
+    static DotKernel dotKernel() {
+#if DISTANCE_X86
+        switch (Distance::level()) {
+        case Distance::Level::AVX512: return dot4x2Avx512;
+        case Distance::Level::AVX2: return dot4x2Avx2;
+        default: break;
+        }
+#endif
+        return dot4x2Scalar;
+    }
+
+    static void dot4x2Scalar(const double* const* a, const double* const* b, size_t len, double* out) {
+        double acc[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        for (size_t k = 0; k < len; ++k) {
+            double b0 = b[0][k];
+            double b1 = b[1][k];
+            for (int r = 0; r < 4; ++r) {
+                acc[r * 2] += a[r][k] * b0;
+                acc[r * 2 + 1] += a[r][k] * b1;
+            }
+        }
+        std::copy(acc, acc + 8, out);
+    }
+
+#if DISTANCE_X86
+    __attribute__((target("avx2,fma")))
+    static void dot4x2Avx2(const double* const* a, const double* const* b, size_t len, double* out) {
+        __m256d acc[8];
+        for (int i = 0; i < 8; ++i) acc[i] = _mm256_setzero_pd();
+        for (size_t k = 0; k < len; k += 4) {
+            __m256d b0 = _mm256_loadu_pd(b[0] + k);
+            __m256d b1 = _mm256_loadu_pd(b[1] + k);
+            for (int r = 0; r < 4; ++r) {
+                __m256d ar = _mm256_loadu_pd(a[r] + k);
+                acc[r * 2] = _mm256_fmadd_pd(ar, b0, acc[r * 2]);
+                acc[r * 2 + 1] = _mm256_fmadd_pd(ar, b1, acc[r * 2 + 1]);
+            }
+        }
+        for (int i = 0; i < 8; ++i) {
+            alignas(32) double lanes[4];
+            _mm256_store_pd(lanes, acc[i]);
+            out[i] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    static void dot4x2Avx512(const double* const* a, const double* const* b, size_t len, double* out) {
+        __m512d acc[8];
+        for (int i = 0; i < 8; ++i) acc[i] = _mm512_setzero_pd();
+        for (size_t k = 0; k < len; k += 8) {
+            __m512d b0 = _mm512_loadu_pd(b[0] + k);
+            __m512d b1 = _mm512_loadu_pd(b[1] + k);
+            for (int r = 0; r < 4; ++r) {
+                __m512d ar = _mm512_loadu_pd(a[r] + k);
+                acc[r * 2] = _mm512_fmadd_pd(ar, b0, acc[r * 2]);
+                acc[r * 2 + 1] = _mm512_fmadd_pd(ar, b1, acc[r * 2 + 1]);
+            }
+        }
+        for (int i = 0; i < 8; ++i) {
+            alignas(64) double lanes[8];
+            _mm512_store_pd(lanes, acc[i]);
+            out[i] = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+        }
+    }
+#endif
+};
+
+#endif
@@ -0,0 +1,236 @@
+// CompactKDTree.h
+#ifndef COMPACTKDTREE_H
+#define COMPACTKDTREE_H
+
+#include "CompactPointStore.h"
+#include "Distance.h"
+#include "NeighborIndex.h"
+#include "Metrics.h"
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <atomic>
+
+// ArenaKDTree's node pool over a CompactPointStore, so points take 4, 2 or 1
+// bytes per coordinate instead of 8. Splits and distances use the decoded
+// rows. A decoded distance d brackets the true one within the error norms e of
+// the two rows (plus float rounding), so a candidate is accepted when
+// d + e <= eps, rejected when d - e > eps, and only otherwise re-checked on the
+// exact rows: neighborhoods are identical to the double-precision trees'.
+class CompactKDTree : public NeighborIndex {
+public:
+    using Precision = CompactPointStore::Precision;
+
+    struct Node {
+        int32_t left;
+        int32_t right;
+        int32_t id;
+        int32_t axis;
+    };
+
+    static constexpr int32_t nil = -1;
+
+    CompactKDTree(int dimensions, Precision precision = Precision::Float32, const std::string& exactPath = "")
+        : dimensions(dimensions), store(dimensions, precision, exactPath), root(nil),
+          floatSlack((dimensions + 4) * std::numeric_limits<float>::epsilon()) {}
+
+    void reserve(size_t n) {
+        store.reserve(n);
+        pool.reserve(n);
+    }
+
+    void insert(const std::vector<double>& point, int index) override {
+        store.set(index, point);
+        registerId(index);
+        if (index >= static_cast<int>(removed.size())) removed.resize(index + 1, 0);
+        removed[index] = 0;
+        ++live;
+        int32_t slot = static_cast<int32_t>(pool.size());
+        pool.push_back({nil, nil, index, 0});
+
+        if (root == nil) {
+            root = slot;
+            pointInserted(index);
+            return;
+        }
+        int32_t current = root;
+        int depth = 0;
+        while (true) {
+            Node& node = pool[current];
+            int32_t& next = store.coordinate(index, node.axis) < store.coordinate(node.id, node.axis) ? node.left : node.right;
+            ++depth;
+            if (next == nil) {
+                next = slot;
+                pool[slot].axis = depth % dimensions;
+                pointInserted(index);
+                return;
+            }
+            current = next;
+        }
+    }
+
+    void removeById(int id) override {
+        if (id >= 0 && id < static_cast<int>(removed.size()) && !removed[id]) {
+            pointRemoving(id);
+            removed[id] = 1;
+            --live;
+        }
+    }
+
+    //Collect the ids (and optionally exact squared distances) of all points within radius of target
+    void radiusSearchIds(const std::vector<double>& target, double radius, std::vector<int>& ids, std::vector<double>* sqDistances = nullptr) const override {
+        search(target.data(), radius, ids, sqDistances);
+    }
+
+    //Radius search around a stored point, addressed by id
+    void radiusSearchById(int id, double radius, std::vector<int>& ids, std::vector<double>* sqDistances = nullptr) const override {
+        ids.clear();
+        if (sqDistances) sqDistances->clear();
+        if (id < 0 || id >= static_cast<int>(removed.size()) || removed[id]) return;
+        std::vector<double> target(dimensions);
+        store.exactRow(id, target.data());
+        search(target.data(), radius, ids, sqDistances);
+    }
+
+    //Marks come from the decoded bracket; only pairs straddling innerRadius read their exact row
+    void radiusSearchByIdSplit(int id, double radius, double innerRadius, std::vector<int>& ids, std::vector<char>& inner) const override {
+        ids.clear();
+        inner.clear();
+        if (id < 0 || id >= static_cast<int>(removed.size()) || removed[id]) return;
+        std::vector<double> target(dimensions);
+        store.exactRow(id, target.data());
+        search(target.data(), radius, ids, nullptr, innerRadius, &inner);
+    }
+
+    std::vector<double> getPoint(int id) const override {
+        std::vector<double> point(dimensions);
+        store.exactRow(id, point.data());
+        return point;
+    }
+
+    int size() const override {
+        return live;
+    }
+
+    Precision precision() const {
+        return store.storedPrecision();
+    }
+
+    //Pairs settled on the exact rows since construction
+    size_t exactChecks() const {
+        return rechecks.load();
+    }
+
+    //Bytes held in memory by the compact rows and the node pool (the exact tier is on disk)
+    size_t memoryUsage() const {
+        return store.memoryUsage() + pool.capacity() * sizeof(Node) + removed.capacity();
+    }
+
+private:
+    struct Query {
+        const double* exact;
+        std::vector<float> compact;
+        double compactError;
+        double radius;
+        double radiusSq;
+        double pruneRadius;
+        double innerRadius;
+        // Bracket on the true distance of the last pair accepts() decoded
+        double low;
+        double high;
+        std::vector<float> decoded;
+        std::vector<double> exactRow;
+    };
+
+    int dimensions;
+    CompactPointStore store;
+    std::vector<Node> pool;
+    std::vector<char> removed;
+    int32_t root;
+    int live = 0;
+    // Relative rounding of a float squared distance over `dimensions` terms
+    double floatSlack;
+    mutable std::atomic<size_t> rechecks{0};
+
+    void search(const double* target, double radius, std::vector<int>& ids, std::vector<double>* sqDistances, double innerRadius = 0.0, std::vector<char>* inner = nullptr) const {
+        METRIC_SCOPE(RadiusQuery);
+        METRIC_ADD(RadiusQueries, 1);
+        ids.clear();
+        if (sqDistances) sqDistances->clear();
+        Query query;
+        query.exact = target;
+        query.compact.assign(store.rowStride(), 0.0f);
+        double errorSq = 0.0;
+        for (int k = 0; k < dimensions; ++k) {
+            query.compact[k] = static_cast<float>(target[k]);
+            double diff = target[k] - query.compact[k];
+            errorSq += diff * diff;
+        }
+        query.compactError = std::sqrt(errorSq) * (1.0 + 1e-9);
+        query.radius = radius;
+        query.radiusSq = radius * radius;
+        //A true neighbor's decoded coordinates are off by at most both rows' errors
+        query.pruneRadius = radius + query.compactError + store.largestError();
+        query.innerRadius = innerRadius;
+        query.decoded.resize(store.rowStride());
+        query.exactRow.resize(dimensions);
+        searchRec(root, query, ids, sqDistances, inner);
+    }
+
+    void searchRec(int32_t current, Query& query, std::vector<int>& ids, std::vector<double>* sqDistances, std::vector<char>* inner) const {
+        if (current == nil) return;
+
+        const Node& node = pool[current];
+        METRIC_ADD(NodesVisited, 1);
+        if (!removed[node.id] && accepts(node.id, query)) {
+            ids.push_back(node.id);
+            if (sqDistances) {
+                store.exactRow(node.id, query.exactRow.data());
+                sqDistances->push_back(Distance::squared(query.exactRow.data(), query.exact, dimensions));
+            }
+            if (inner) inner->push_back(withinInner(node.id, query));
+        }
+
+        float split = store.coordinate(node.id, node.axis);
+        float t = query.compact[node.axis];
+        if (t - query.pruneRadius <= split)
+            searchRec(node.left, query, ids, sqDistances, inner);
+        if (t + query.pruneRadius >= split)
+            searchRec(node.right, query, ids, sqDistances, inner);
+    }
+
+    bool accepts(int id, Query& query) const {
+        double slack = query.compactError + store.error(id);
+        //Past this the pair is out even allowing for encoding error and float rounding
+        double outer = (query.radius + slack) * (query.radius + slack) * (1.0 + floatSlack);
+        const float* row = store.decode(id, query.decoded.data());
+        METRIC_ADD(DistanceEvaluations, 1);
+        //Bound rounded up, so an early exit always means distSq > outer
+        float bound = std::nextafter(static_cast<float>(outer), std::numeric_limits<float>::infinity());
+        double distSq = Distance::squaredBounded(row, query.compact.data(), dimensions, bound);
+        if (distSq > outer) return false;
+
+        query.low = std::sqrt(distSq / (1.0 + floatSlack)) - slack;
+        query.high = std::sqrt(distSq / (1.0 - floatSlack)) + slack;
+        if (query.high <= query.radius) return true;
+        if (query.low > query.radius) return false;
+
+        rechecks.fetch_add(1, std::memory_order_relaxed);
+        store.exactRow(id, query.exactRow.data());
+        return Distance::squaredBounded(query.exactRow.data(), query.exact, dimensions, query.radiusSq) <= query.radiusSq;
+    }
+
+    //Whether a pair accepts() just took lies within the inner radius, settled as accepts() settles the radius
+    bool withinInner(int id, Query& query) const {
+        if (query.innerRadius >= query.radius || query.high <= query.innerRadius) return true;
+        if (query.low > query.innerRadius) return false;
+
+        rechecks.fetch_add(1, std::memory_order_relaxed);
+        store.exactRow(id, query.exactRow.data());
+        double innerSq = query.innerRadius * query.innerRadius;
+        return Distance::squaredBounded(query.exactRow.data(), query.exact, dimensions, innerSq) <= innerSq;
+    }
+};
+
+#endif
@@ -0,0 +1,247 @@
+// CompactPointStore.h
+#ifndef COMPACTPOINTSTORE_H
+#define COMPACTPOINTSTORE_H
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <unistd.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define COMPACTPOINTSTORE_X86 1
+#endif
+
+// Point rows kept in memory at reduced precision: float32, fp16, or int8 with
+// one scale per row. Each row also records the euclidean norm of its encoding
+// error, so a distance measured on decoded rows brackets the true distance
+// within the two rows' errors. Pairs whose bracket straddles eps are settled
+// against the exact tier, which keeps the original double rows in a file
+// (anonymous unless a path is given) read back with pread, so only the compact
+// rows take memory.
+class CompactPointStore {
+public:
+    enum class Precision { Float32, Float16, Int8 };
+
+    CompactPointStore(int dimensions, Precision precision, const std::string& exactPath = "")
+        : dimensions(dimensions), stride((dimensions + 15) / 16 * 16), precision(precision) {
+        exactFile = exactPath.empty() ? std::tmpfile() : std::fopen(exactPath.c_str(), "w+b");
+        if (!exactFile) throw std::runtime_error("CompactPointStore: cannot open exact tier file");
+        exactFd = fileno(exactFile);
+    }
+
+    ~CompactPointStore() {
+        std::fclose(exactFile);
+    }
+
+    CompactPointStore(const CompactPointStore&) = delete;
+    CompactPointStore& operator=(const CompactPointStore&) = delete;
+
+    static const char* precisionName(Precision p) {
+        switch (p) {
+        case Precision::Float16: return "fp16";
+        case Precision::Int8: return "int8";
+        default: return "float32";
+        }
+    }
+
+    void reserve(size_t n) {
+        switch (precision) {
+        case Precision::Float32: f32.reserve(n * stride); break;
+        case Precision::Float16: f16.reserve(n * stride); break;
+        case Precision::Int8: i8.reserve(n * stride); scales.reserve(n); break;
+        }
+        errors.reserve(n);
+    }
+
+    //Encode the point into row `id` and write it to the exact tier
+    void set(size_t id, const std::vector<double>& point) {
+        if (id >= rows) grow(id + 1);
+        ssize_t bytes = static_cast<ssize_t>(dimensions * sizeof(double));
+        if (pwrite(exactFd, point.data(), bytes, static_cast<off_t>(id * bytes)) != bytes) {
+            throw std::runtime_error("CompactPointStore: exact tier write failed");
+        }
+
+        switch (precision) {
+        case Precision::Float32: {
+            float* row = &f32[id * stride];
+            for (int k = 0; k < dimensions; ++k) row[k] = static_cast<float>(point[k]);
+            break;
+        }
+        case Precision::Float16: {
+            uint16_t* row = &f16[id * stride];
+            for (int k = 0; k < dimensions; ++k) row[k] = toHalf(static_cast<float>(point[k]));
+            break;
+        }
+        case Precision::Int8: {
+            double maxAbs = 0.0;
+            for (int k = 0; k < dimensions; ++k) maxAbs = std::max(maxAbs, std::fabs(point[k]));
+            float scale = maxAbs > 0.0 ? static_cast<float>(maxAbs / 127.0) : 1.0f;
+            int8_t* row = &i8[id * stride];
+            for (int k = 0; k < dimensions; ++k) {
+                row[k] = static_cast<int8_t>(std::clamp(std::lround(point[k] / scale), -127L, 127L));
+            }
+            scales[id] = scale;
+            break;
+        }
+        }
+
+        std::vector<float> decoded(stride);
+        const float* d = decode(id, decoded.data());
+        double errorSq = 0.0;
+        for (int k = 0; k < dimensions; ++k) {
+            double diff = point[k] - d[k];
+            errorSq += diff * diff;
+        }
+        //Padded up so rounding in this sum cannot make the bound too tight
+        errors[id] = std::sqrt(errorSq) * (1.0 + 1e-9);
+        maxError = std::max(maxError, errors[id]);
+    }
+
+    //Decoded row `id`: a pointer into the store for float32, otherwise decoded into buffer (stride floats)
+    const float* decode(size_t id, float* buffer) const {
+        switch (precision) {
+        case Precision::Float32:
+            return &f32[id * stride];
+        case Precision::Float16:
+            decodeHalf(&f16[id * stride], buffer, stride);
+            return buffer;
+        case Precision::Int8: {
+            const int8_t* row = &i8[id * stride];
+            float scale = scales[id];
+            for (size_t k = 0; k < stride; ++k) buffer[k] = row[k] * scale;
+            return buffer;
+        }
+        }
+        return buffer;
+    }
+
+    //Decoded coordinate `axis` of row `id`
+    float coordinate(size_t id, int axis) const {
+        switch (precision) {
+        case Precision::Float32: return f32[id * stride + axis];
+        case Precision::Float16: return fromHalf(f16[id * stride + axis]);
+        case Precision::Int8: return i8[id * stride + axis] * scales[id];
+        }
+        return 0.0f;
+    }
+
+    //Norm of the difference between row `id` and its decoding
+    double error(size_t id) const { return errors[id]; }
+
+    //Largest error of any row, the slack a per-coordinate bound needs
+    double largestError() const { return maxError; }
+
+    //Original double coordinates of row `id`, read back from the exact tier
+    void exactRow(size_t id, double* out) const {
+        ssize_t bytes = static_cast<ssize_t>(dimensions * sizeof(double));
+        if (pread(exactFd, out, bytes, static_cast<off_t>(id * bytes)) != bytes) {
+            throw std::runtime_error("CompactPointStore: exact tier read failed");
+        }
+    }
+
+    size_t size() const { return rows; }
+    int dims() const { return dimensions; }
+    size_t rowStride() const { return stride; }
+    Precision storedPrecision() const { return precision; }
+
+    //Bytes held in memory by the compact rows and their per-row scale and error
+    size_t memoryUsage() const {
+        return f32.capacity() * sizeof(float) + f16.capacity() * sizeof(uint16_t) + i8.capacity() +
+               scales.capacity() * sizeof(float) + errors.capacity() * sizeof(double);
+    }
+
+    //Round-to-nearest-even float to IEEE half conversion
+    static uint16_t toHalf(float f) {
+        uint32_t x;
+        std::memcpy(&x, &f, sizeof(x));
+        uint32_t sign = (x >> 16) & 0x8000;
+        uint32_t biased = (x >> 23) & 0xff;
+        uint32_t mant = x & 0x7fffff;
+        if (biased == 0xff) return static_cast<uint16_t>(sign | 0x7c00 | (mant ? 0x200 : 0));
+        int32_t exp = static_cast<int32_t>(biased) - 127 + 15;
+        if (exp >= 31) return static_cast<uint16_t>(sign | 0x7c00);
+        if (exp <= 0) {
+            if (exp < -10) return static_cast<uint16_t>(sign);
+            mant |= 0x800000;
+            int shift = 14 - exp;
+            uint32_t half = mant >> shift;
+            uint32_t rem = mant & ((1u << shift) - 1);
+            uint32_t mid = 1u << (shift - 1);
+            if (rem > mid || (rem == mid && (half & 1))) ++half;
+            return static_cast<uint16_t>(sign | half);
+        }
+        uint32_t half = sign | (static_cast<uint32_t>(exp) << 10) | (mant >> 13);
+        uint32_t rem = mant & 0x1fff;
+        //A carry out of the mantissa correctly bumps the exponent
+        if (rem > 0x1000 || (rem == 0x1000 && (half & 1))) ++half;
+        return static_cast<uint16_t>(half);
+    }
+
+    static float fromHalf(uint16_t h) {
+        uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+        uint32_t exp = (h >> 10) & 0x1f;
+        uint32_t mant = h & 0x3ff;
+        if (exp == 0) {
+            float f = std::ldexp(static_cast<float>(mant), -24);
+            return sign ? -f : f;
+        }
+        uint32_t x = exp == 31 ? (sign | 0x7f800000 | (mant << 13)) : (sign | ((exp - 15 + 127) << 23) | (mant << 13));
+        float f;
+        std::memcpy(&f, &x, sizeof(f));
+        return f;
+    }
+
+private:
+    int dimensions;
+    size_t stride;
+    Precision precision;
+    size_t rows = 0;
+    std::vector<float> f32;
+    std::vector<uint16_t> f16;
+    std::vector<int8_t> i8;
+    std::vector<float> scales;
+    std::vector<double> errors;
+    double maxError = 0.0;
+    std::FILE* exactFile;
+    int exactFd;
+
+    void grow(size_t n) {
+        switch (precision) {
+        case Precision::Float32: f32.resize(n * stride, 0.0f); break;
+        case Precision::Float16: f16.resize(n * stride, 0); break;
+        case Precision::Int8: i8.resize(n * stride, 0); scales.resize(n, 1.0f); break;
+        }
+        errors.resize(n, 0.0);
+        rows = n;
+    }
+
+    static void decodeHalf(const uint16_t* in, float* out, size_t n) {
+#if COMPACTPOINTSTORE_X86
+        static const bool f16c = __builtin_cpu_supports("f16c");
+        if (f16c) {
+            decodeHalfF16C(in, out, n);
+            return;
+        }
+#endif
+        for (size_t k = 0; k < n; ++k) out[k] = fromHalf(in[k]);
+    }
+
+#if COMPACTPOINTSTORE_X86
+    //n is a multiple of 16 (the row stride)
+    __attribute__((target("avx,f16c")))
+    static void decodeHalfF16C(const uint16_t* in, float* out, size_t n) {
+        for (size_t k = 0; k < n; k += 8) {
+            __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + k));
+            _mm256_storeu_ps(out + k, _mm256_cvtph_ps(h));
+        }
+    }
+#endif
+};
+
+#endif
@@ -0,0 +1,49 @@
+// ConcurrentDisjointSet.h
+#ifndef CONCURRENTDISJOINTSET_H
+#define CONCURRENTDISJOINTSET_H
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+// Lock-free union-find over 0..n-1 for threads uniting concurrently. A root is
+// always linked under a smaller root by compare-and-swap, so the representative
+// of every set is its smallest element no matter how the unions interleave.
+class ConcurrentDisjointSet {
+public:
+    explicit ConcurrentDisjointSet(int n) : count(n), parent(new std::atomic<int>[n]) {
+        for (int i = 0; i < n; ++i) parent[i].store(i, std::memory_order_relaxed);
+    }
+
+    //Representative (smallest element) of x's set, halving the path on the way
+    int find(int x) {
+        while (true) {
+            int p = parent[x].load(std::memory_order_acquire);
+            if (p == x) return x;
+            int gp = parent[p].load(std::memory_order_acquire);
+            //Only ever shortcuts to an ancestor, so a failed exchange is harmless
+            if (gp != p) parent[x].compare_exchange_weak(p, gp, std::memory_order_acq_rel);
+            x = gp;
+        }
+    }
+
+    void unite(int a, int b) {
+        while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b) return;
+            if (a < b) std::swap(a, b);
+            //a is the larger root; hang it under b unless another thread relinked it first
+            int expected = a;
+            if (parent[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel)) return;
+        }
+    }
+
+    int size() const { return count; }
+
+private:
+    int count;
+    std::unique_ptr<std::atomic<int>[]> parent;
+};
+
+#endif
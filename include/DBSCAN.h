@@ -2,45 +2,60 @@
 #ifndef DBSCAN_H
 #define DBSCAN_H
 
+#include "NeighborIndex.h"
 #include "KDTree.h"
+#include "ConcurrentDisjointSet.h"
+#include "ParallelFor.h"
+#include "Metrics.h"
+#include "EpochMarks.h"
 #include <vector>
 #include <unordered_map>
-#include <set>
 #include <chrono>
+#include <algorithm>
 
 class DBSCAN {
 public:
-    DBSCAN(double eps, int minPts, KDTree& kdTree, int& clusterID)
-        : eps(eps), minPts(minPts), kdTree(kdTree), clusterID(clusterID) {}
+    DBSCAN(double eps, int minPts, NeighborIndex& searchIndex, int& clusterID)
+        : eps(eps), minPts(minPts), searchIndex(searchIndex), clusterID(clusterID) {}
 
     void cluster(const std::vector<std::vector<double>>& points) {
+        METRIC_SCOPE(DBSCANCluster);
+        bool log = Metrics::logging();
         // Initialize all points as not visited
         visited.assign(points.size(), false);
         clusters.assign(points.size(), -1);
         auto start = std::chrono::high_resolution_clock::now();
-        // Insert points into KD-Tree
-        for (size_t i = 0; i < points.size(); ++i) {
-            kdTree.insert(points[i], i);
-        }
-        std::cout << "KDTree size: " << kdTree.size() << std::endl;
+        // Bulk load points into a balanced KD-Tree
+        searchIndex.build(points, 0);
+        if (log) std::cout << "Index size: " << searchIndex.size() << std::endl;
         auto end = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
         auto durationInSeconds = duration / 1e6; // Convert microseconds to seconds
-        std::cout << "Time taken to insert all the points into the KDTree: " << durationInSeconds << " seconds" << std::endl;
+        if (log) std::cout << "Time taken to insert all the points into the KDTree: " << durationInSeconds << " seconds" << std::endl;
 
         // Process each point
         start = std::chrono::high_resolution_clock::now();
-        for (size_t i = 0; i < points.size(); ++i) {
-            if (!visited[i]) {
-                if (expandCluster(points, i)) {
-                    clusterID++;
+        if (numThreads > 1 || searchIndex.batchQueries()) {
+            clusterByComponents(points);
+        } else {
+            for (size_t i = 0; i < points.size(); ++i) {
+                if (!visited[i]) {
+                    if (expandCluster(points, i)) {
+                        clusterID++;
+                    }
                 }
             }
         }
         end = std::chrono::high_resolution_clock::now();
         duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
         durationInSeconds = duration / 1e6; // Convert microseconds to seconds
-        std::cout << "Time taken to cluster: " << durationInSeconds << " seconds" << std::endl;
+        if (log) std::cout << "Time taken to cluster: " << durationInSeconds << " seconds" << std::endl;
+    }
+
+    //Threads used by cluster(); 1 runs the sequential expansion, 0 uses every hardware thread.
+    //Backends with batch queries (BruteForceEngine) always take the component path.
+    void setNumThreads(int threads) {
+        numThreads = resolveThreadCount(threads);
     }
 
     void getClustersLabels(std::vector<int>& clusterIds, int& clusterID) {
@@ -56,17 +71,95 @@ private:
     double eps;
     int minPts;
     int clusterID;
-    KDTree& kdTree;
+    NeighborIndex& searchIndex;
     std::vector<bool> visited;
     std::vector<int> clusters;
+    // Reused neighbor id buffers for the seed and the expansion queries
+    std::vector<int> neighbors;
+    std::vector<int> currentNeighbors;
+    // Reused seed queue and its membership for expandCluster
+    std::vector<int> seeds;
+    EpochMarks queued;
+    int numThreads = 1;
 
-    bool expandCluster(const std::vector<std::vector<double>>& points, size_t index) {
-        auto start = std::chrono::high_resolution_clock::now();
-        auto neighbors_of_index = kdTree.radiusSearch(points[index], eps);
-        std::vector<size_t> neighbors;
-        for (const auto& neighbor : neighbors_of_index) {
-            neighbors.push_back(kdTree.getIndex(neighbor));
+    // Same labels as the sequential expansion. Clusters are the connected
+    // components of core points, numbered in order of their smallest core
+    // index (the point the sequential loop would have started them from),
+    // and a border point joins the earliest-numbered cluster among its core
+    // neighbors, the one whose expansion would have reached it first.
+    void clusterByComponents(const std::vector<std::vector<double>>& points) {
+        size_t n = points.size();
+        //Neighborhoods as CSR: the neighbors of point i are ids[offsets[i]..offsets[i+1])
+        std::vector<int> offsets;
+        std::vector<int> ids;
+        if (searchIndex.batchQueries()) {
+            std::vector<int> queryIds(n);
+            for (size_t i = 0; i < n; ++i) queryIds[i] = static_cast<int>(i);
+            searchIndex.radiusSearchBatch(queryIds, eps, offsets, ids);
+        } else {
+            std::vector<std::vector<int>> neighborhoods(n);
+            parallelFor(numThreads, n, 64, [&](size_t i) {
+                searchIndex.radiusSearchIds(points[i], eps, neighborhoods[i]);
+            });
+            offsets.assign(n + 1, 0);
+            for (size_t i = 0; i < n; ++i) offsets[i + 1] = offsets[i] + static_cast<int>(neighborhoods[i].size());
+            ids.resize(offsets[n]);
+            parallelFor(numThreads, n, 64, [&](size_t i) {
+                std::copy(neighborhoods[i].begin(), neighborhoods[i].end(), ids.begin() + offsets[i]);
+            });
+        }
+
+        std::vector<char> core(n, 0);
+        for (size_t i = 0; i < n; ++i) {
+            int count = offsets[i + 1] - offsets[i];
+            core[i] = count >= minPts;
+            searchIndex.recordNeighborCount(static_cast<int>(i), eps, count);
         }
+
+        //Union every core point with its core neighbors; each set ends up rooted at its smallest index
+        ConcurrentDisjointSet components(static_cast<int>(n));
+        parallelFor(numThreads, n, 64, [&](size_t i) {
+            if (!core[i]) return;
+            for (int k = offsets[i]; k < offsets[i + 1]; ++k) {
+                int j = ids[k];
+                if (core[j] && j < static_cast<int>(i)) components.unite(static_cast<int>(i), j);
+            }
+        });
+
+        std::vector<int> root(n, -1);
+        parallelFor(numThreads, n, 64, [&](size_t i) {
+            if (core[i]) {
+                root[i] = components.find(static_cast<int>(i));
+                return;
+            }
+            for (int k = offsets[i]; k < offsets[i + 1]; ++k) {
+                int j = ids[k];
+                if (core[j]) {
+                    int r = components.find(j);
+                    if (root[i] < 0 || r < root[i]) root[i] = r;
+                }
+            }
+        });
+
+        //Roots in ascending order get consecutive cluster ids
+        std::vector<int> rootCluster(n, -1);
+        for (size_t i = 0; i < n; ++i) {
+            if (core[i] && root[i] == static_cast<int>(i)) rootCluster[i] = clusterID++;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (root[i] < 0) {
+                clusters[i] = -1; // Mark as noise
+                continue;
+            }
+            visited[i] = true;
+            clusters[i] = rootCluster[root[i]];
+            searchIndex.assignClusterIdById(static_cast<int>(i), clusters[i]);
+        }
+    }
+
+    bool expandCluster(const std::vector<std::vector<double>>& points, size_t index) {
+        searchIndex.radiusSearchIds(points[index], eps, neighbors);
+        searchIndex.recordNeighborCount(index, eps, static_cast<int>(neighbors.size()));
         // auto end = std::chrono::high_resolution_clock::now();
         // auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
         // auto durationInSeconds = duration / 1e6; // Convert microseconds to seconds
@@ -75,38 +168,33 @@ private:
             clusters[index] = -1; // Mark as noise
             return false;
         } else {
-            kdTree.assignClusterID(points[index], clusterID);
+            searchIndex.assignClusterIdById(index, clusterID);
             int currentClusterID = clusterID;
-            std::set<size_t> seeds(neighbors.begin(), neighbors.end());
-            seeds.erase(index);
+            //Flat FIFO of seeds; each point enters it once per expansion
+            seeds.clear();
+            queued.reset(points.size());
+            queued.insert(static_cast<int>(index));
+            for (int neighbor : neighbors) {
+                if (queued.insert(neighbor)) seeds.push_back(neighbor);
+            }
             clusters[index] = currentClusterID;
-            auto start = std::chrono::high_resolution_clock::now();
-            while (!seeds.empty()) {
-                size_t currentPoint = *seeds.begin();
-                seeds.erase(seeds.begin());
+            METRIC_SCOPE(ExpandCluster);
+            METRIC_ADD(ClusterExpansions, 1);
+            for (size_t next = 0; next < seeds.size(); ++next) {
+                size_t currentPoint = seeds[next];
                 if (!visited[currentPoint]) {
                     visited[currentPoint] = true;
-                    // auto start = std::chrono::high_resolution_clock::now();
-                    auto neighbors = kdTree.radiusSearch(points[currentPoint], eps);
-                    std::vector<size_t> currentNeighbors;
-                    for (const auto& neighbor : neighbors) {
-                        currentNeighbors.push_back(kdTree.getIndex(neighbor));
-                    }
-                    // auto end = std::chrono::high_resolution_clock::now();
-                    // auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-                    // auto durationInSeconds = duration / 1e6; // Convert microseconds to seconds
-                    // std::cout << "Time taken to find neighbors for index " << currentPoint << " : " << durationInSeconds << " seconds" << std::endl;
+                    searchIndex.radiusSearchIds(points[currentPoint], eps, currentNeighbors);
+                    searchIndex.recordNeighborCount(currentPoint, eps, static_cast<int>(currentNeighbors.size()));
                     if (currentNeighbors.size() >= minPts) {
-                        seeds.insert(currentNeighbors.begin(), currentNeighbors.end());
+                        for (int neighbor : currentNeighbors) {
+                            if (!visited[neighbor] && queued.insert(neighbor)) seeds.push_back(neighbor);
+                        }
                     }
                     clusters[currentPoint] = currentClusterID;
-                    kdTree.assignClusterID(points[currentPoint], clusterID); 
+                    searchIndex.assignClusterIdById(currentPoint, clusterID); 
                 }
             }
-            auto end = std::chrono::high_resolution_clock::now();
-            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-            auto durationInSeconds = duration / 1e6; // Convert microseconds to seconds
-            std::cout << "Time taken to expand cluster: " << durationInSeconds << " seconds" << std::endl;
             return true;
         }
     }
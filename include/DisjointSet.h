@@ -0,0 +1,66 @@
+// DisjointSet.h
+#ifndef DISJOINTSET_H
+#define DISJOINTSET_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+// Union-find over cluster labels 0, 1, 2, ... with path compression and union
+// by size. A label that was never merged is its own representative.
+class DisjointSet {
+public:
+    //Make sure labels 0..label exist, each in its own set
+    void ensure(int label) {
+        while (static_cast<int>(parent.size()) <= label) {
+            parent.push_back(static_cast<int>(parent.size()));
+            setSize.push_back(1);
+        }
+    }
+
+    //Representative of label, compressing the path on the way
+    int find(int label) {
+        if (label < 0 || label >= static_cast<int>(parent.size())) return label;
+        while (parent[label] != label) {
+            parent[label] = parent[parent[label]];
+            label = parent[label];
+        }
+        return label;
+    }
+
+    //Representative of label without modifying the structure
+    int root(int label) const {
+        if (label < 0 || label >= static_cast<int>(parent.size())) return label;
+        while (parent[label] != label) {
+            label = parent[label];
+        }
+        return label;
+    }
+
+    //Merge the sets of a and b; returns the representative of the merged set
+    int unite(int a, int b) {
+        ensure(std::max(a, b));
+        a = find(a);
+        b = find(b);
+        if (a == b) return a;
+        if (setSize[a] < setSize[b]) std::swap(a, b);
+        parent[b] = a;
+        setSize[a] += setSize[b];
+        return a;
+    }
+
+    //Drop all merges and start over with count singleton labels
+    void reset(int count) {
+        parent.resize(count);
+        setSize.assign(count, 1);
+        for (int label = 0; label < count; ++label) parent[label] = label;
+    }
+
+    int labels() const { return static_cast<int>(parent.size()); }
+
+private:
+    std::vector<int> parent;
+    std::vector<int> setSize;
+};
+
+#endif
@@ -0,0 +1,391 @@
+// Distance.h
+#ifndef DISTANCE_H
+#define DISTANCE_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DISTANCE_X86 1
+#include <immintrin.h>
+#endif
+
+// Squared euclidean distance kernels for double and float rows, and a dot
+// product kernel for double rows (cosine and inner-product search).
+// The bounded variants stop summing as soon as the running total exceeds the
+// bound (checked once per block of dimensions) and then return that partial
+// sum, so callers test `result <= bound` against eps² without any sqrt.
+// The widest instruction set the CPU supports (AVX-512, AVX2, SSE2) is picked
+// once at startup; INCDBSCAN_SIMD=scalar|sse2|avx2|avx512 or setLevel()
+// overrides it.
+class Distance {
+public:
+    enum class Level { Scalar, SSE2, AVX2, AVX512 };
+
+    static Level level() {
+        return state().level;
+    }
+
+    //Select a kernel level, clamped to what the CPU supports; call before searching
+    static void setLevel(Level requested) {
+        state() = makeState(requested);
+    }
+
+    static const char* levelName(Level l) {
+        switch (l) {
+        case Level::AVX512: return "avx512";
+        case Level::AVX2: return "avx2";
+        case Level::SSE2: return "sse2";
+        default: return "scalar";
+        }
+    }
+
+    static double squaredBounded(const double* a, const double* b, size_t n, double bound) {
+        return state().f64(a, b, n, bound);
+    }
+
+    static float squaredBounded(const float* a, const float* b, size_t n, float bound) {
+        return state().f32(a, b, n, bound);
+    }
+
+    static double squared(const double* a, const double* b, size_t n) {
+        return state().f64(a, b, n, std::numeric_limits<double>::infinity());
+    }
+
+    static float squared(const float* a, const float* b, size_t n) {
+        return state().f32(a, b, n, std::numeric_limits<float>::infinity());
+    }
+
+    static double dot(const double* a, const double* b, size_t n) {
+        return state().dot(a, b, n);
+    }
+
+private:
+    using KernelF64 = double (*)(const double*, const double*, size_t, double);
+    using KernelF32 = float (*)(const float*, const float*, size_t, float);
+    using KernelDot = double (*)(const double*, const double*, size_t);
+
+    // Dimensions summed between two checks against the bound
+    static constexpr size_t block = 64;
+
+    struct State {
+        Level level;
+        KernelF64 f64;
+        KernelF32 f32;
+        KernelDot dot;
+    };
+
+    static State& state() {
+        static State s = makeState(requestedLevel());
+        return s;
+    }
+
+    static State makeState(Level requested) {
+        Level best = detectLevel();
+        if (static_cast<int>(requested) > static_cast<int>(best)) requested = best;
+        switch (requested) {
+#if DISTANCE_X86
+        case Level::AVX512: return {Level::AVX512, avx512Bounded, avx512BoundedF, avx512Dot};
+        case Level::AVX2: return {Level::AVX2, avx2Bounded, avx2BoundedF, avx2Dot};
+        case Level::SSE2: return {Level::SSE2, sse2Bounded, sse2BoundedF, sse2Dot};
+#endif
+        default: return {Level::Scalar, scalarBounded<double>, scalarBounded<float>, scalarDot};
+        }
+    }
+
+    static Level requestedLevel() {
+        const char* env = std::getenv("INCDBSCAN_SIMD");
+        if (env) {
+            if (!std::strcmp(env, "scalar")) return Level::Scalar;
+            if (!std::strcmp(env, "sse2")) return Level::SSE2;
+            if (!std::strcmp(env, "avx2")) return Level::AVX2;
+        }
+        return Level::AVX512;
+    }
+
+    static Level detectLevel() {
+#if DISTANCE_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return Level::AVX512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return Level::AVX2;
+        if (__builtin_cpu_supports("sse2")) return Level::SSE2;
+#endif
+        return Level::Scalar;
+    }
+
+    template <typename T>
+    static T scalarBounded(const T* a, const T* b, size_t n, T bound) {
+        T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        size_t i = 0;
+        while (i + 4 <= n) {
+            size_t end = i + block <= n ? i + block : n & ~size_t(3);
+            for (; i < end; i += 4) {
+                T d0 = a[i] - b[i], d1 = a[i + 1] - b[i + 1], d2 = a[i + 2] - b[i + 2], d3 = a[i + 3] - b[i + 3];
+                s0 += d0 * d0;
+                s1 += d1 * d1;
+                s2 += d2 * d2;
+                s3 += d3 * d3;
+            }
+            T partial = (s0 + s1) + (s2 + s3);
+            if (partial > bound) return partial;
+        }
+        T sum = (s0 + s1) + (s2 + s3);
+        for (; i < n; ++i) {
+            T d = a[i] - b[i];
+            sum += d * d;
+        }
+        return sum;
+    }
+
+    static double scalarDot(const double* a, const double* b, size_t n) {
+        double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            s0 += a[i] * b[i];
+            s1 += a[i + 1] * b[i + 1];
+            s2 += a[i + 2] * b[i + 2];
+            s3 += a[i + 3] * b[i + 3];
+        }
+        double sum = (s0 + s1) + (s2 + s3);
+        for (; i < n; ++i) sum += a[i] * b[i];
+        return sum;
+    }
+
+#if DISTANCE_X86
+    __attribute__((target("sse2")))
+    static double sse2Dot(const double* a, const double* b, size_t n) {
+        __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+            acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+        }
+        __m128d s = _mm_add_pd(acc0, acc1);
+        double sum = _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+        for (; i < n; ++i) sum += a[i] * b[i];
+        return sum;
+    }
+
+    __attribute__((target("avx2,fma")))
+    static double avx2Dot(const double* a, const double* b, size_t n) {
+        __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+            acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), acc1);
+        }
+        double sum = hsum256(_mm256_add_pd(acc0, acc1));
+        for (; i < n; ++i) sum += a[i] * b[i];
+        return sum;
+    }
+
+    __attribute__((target("avx512f")))
+    static double avx512Dot(const double* a, const double* b, size_t n) {
+        __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), acc0);
+            acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8), acc1);
+        }
+        for (; i + 8 <= n; i += 8) acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), acc0);
+        if (i < n) {
+            __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+            acc1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a + i), _mm512_maskz_loadu_pd(mask, b + i), acc1);
+        }
+        return hsum512(_mm512_add_pd(acc0, acc1));
+    }
+
+    __attribute__((target("sse2")))
+    static double sse2Bounded(const double* a, const double* b, size_t n, double bound) {
+        __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+        size_t i = 0;
+        while (i + 4 <= n) {
+            size_t end = i + block <= n ? i + block : n & ~size_t(3);
+            for (; i < end; i += 4) {
+                __m128d d0 = _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i));
+                __m128d d1 = _mm_sub_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2));
+                acc0 = _mm_add_pd(acc0, _mm_mul_pd(d0, d0));
+                acc1 = _mm_add_pd(acc1, _mm_mul_pd(d1, d1));
+            }
+            __m128d s = _mm_add_pd(acc0, acc1);
+            double partial = _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+            if (partial > bound) return partial;
+        }
+        __m128d s = _mm_add_pd(acc0, acc1);
+        double sum = _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+        for (; i < n; ++i) {
+            double d = a[i] - b[i];
+            sum += d * d;
+        }
+        return sum;
+    }
+
+    __attribute__((target("sse2")))
+    static float sse2BoundedF(const float* a, const float* b, size_t n, float bound) {
+        __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+        size_t i = 0;
+        while (i + 8 <= n) {
+            size_t end = i + block <= n ? i + block : n & ~size_t(7);
+            for (; i < end; i += 8) {
+                __m128 d0 = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+                __m128 d1 = _mm_sub_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4));
+                acc0 = _mm_add_ps(acc0, _mm_mul_ps(d0, d0));
+                acc1 = _mm_add_ps(acc1, _mm_mul_ps(d1, d1));
+            }
+            float partial = hsum128(_mm_add_ps(acc0, acc1));
+            if (partial > bound) return partial;
+        }
+        float sum = hsum128(_mm_add_ps(acc0, acc1));
+        for (; i < n; ++i) {
+            float d = a[i] - b[i];
+            sum += d * d;
+        }
+        return sum;
+    }
+
+    __attribute__((target("sse2")))
+    static float hsum128(__m128 v) {
+        __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+        __m128 sums = _mm_add_ps(v, shuf);
+        shuf = _mm_movehl_ps(shuf, sums);
+        return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+    }
+
+    __attribute__((target("avx2,fma")))
+    static double avx2Bounded(const double* a, const double* b, size_t n, double bound) {
+        __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+        size_t i = 0;
+        while (i + 8 <= n) {
+            size_t end = i + block <= n ? i + block : n & ~size_t(7);
+            for (; i < end; i += 8) {
+                __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+                __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4));
+                acc0 = _mm256_fmadd_pd(d0, d0, acc0);
+                acc1 = _mm256_fmadd_pd(d1, d1, acc1);
+            }
+            double partial = hsum256(_mm256_add_pd(acc0, acc1));
+            if (partial > bound) return partial;
+        }
+        double sum = hsum256(_mm256_add_pd(acc0, acc1));
+        for (; i < n; ++i) {
+            double d = a[i] - b[i];
+            sum += d * d;
+        }
+        return sum;
+    }
+
+    __attribute__((target("avx2,fma")))
+    static float avx2BoundedF(const float* a, const float* b, size_t n, float bound) {
+        __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+        size_t i = 0;
+        while (i + 16 <= n) {
+            size_t end = i + block <= n ? i + block : n & ~size_t(15);
+            for (; i < end; i += 16) {
+                __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+                __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+                acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+                acc1 = _mm256_fmadd_ps(d1, d1, acc1);
+            }
+            float partial = hsum256f(_mm256_add_ps(acc0, acc1));
+            if (partial > bound) return partial;
+        }
+        float sum = hsum256f(_mm256_add_ps(acc0, acc1));
+        for (; i < n; ++i) {
+            float d = a[i] - b[i];
+            sum += d * d;
+        }
+        return sum;
+    }
+
+    __attribute__((target("avx2")))
+    static double hsum256(__m256d v) {
+        __m128d lo = _mm256_castpd256_pd128(v);
+        __m128d hi = _mm256_extractf128_pd(v, 1);
+        lo = _mm_add_pd(lo, hi);
+        return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+    }
+
+    __attribute__((target("avx2")))
+    static float hsum256f(__m256 v) {
+        __m128 lo = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        __m128 shuf = _mm_movehdup_ps(lo);
+        __m128 sums = _mm_add_ps(lo, shuf);
+        shuf = _mm_movehl_ps(shuf, sums);
+        return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+    }
+
+    __attribute__((target("avx512f")))
+    static double hsum512(__m512d v) {
+        alignas(64) double lanes[8];
+        _mm512_store_pd(lanes, v);
+        return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+
+    __attribute__((target("avx512f")))
+    static float hsum512f(__m512 v) {
+        alignas(64) float lanes[16];
+        _mm512_store_ps(lanes, v);
+        float sum = 0;
+        for (float lane : lanes) sum += lane;
+        return sum;
+    }
+
+    __attribute__((target("avx512f")))
+    static double avx512Bounded(const double* a, const double* b, size_t n, double bound) {
+        __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+        size_t i = 0;
+        while (i + 16 <= n) {
+            size_t end = i + block <= n ? i + block : n & ~size_t(15);
+            for (; i < end; i += 16) {
+                __m512d d0 = _mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i));
+                __m512d d1 = _mm512_sub_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8));
+                acc0 = _mm512_fmadd_pd(d0, d0, acc0);
+                acc1 = _mm512_fmadd_pd(d1, d1, acc1);
+            }
+            double partial = hsum512(_mm512_add_pd(acc0, acc1));
+            if (partial > bound) return partial;
+        }
+        for (; i + 8 <= n; i += 8) {
+            __m512d d = _mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i));
+            acc0 = _mm512_fmadd_pd(d, d, acc0);
+        }
+        if (i < n) {
+            __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+            __m512d d = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, a + i), _mm512_maskz_loadu_pd(mask, b + i));
+            acc1 = _mm512_fmadd_pd(d, d, acc1);
+        }
+        return hsum512(_mm512_add_pd(acc0, acc1));
+    }
+
+    __attribute__((target("avx512f")))
+    static float avx512BoundedF(const float* a, const float* b, size_t n, float bound) {
+        __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+        size_t i = 0;
+        while (i + 32 <= n) {
+            size_t end = i + block <= n ? i + block : n & ~size_t(31);
+            for (; i < end; i += 32) {
+                __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+                __m512 d1 = _mm512_sub_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16));
+                acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+                acc1 = _mm512_fmadd_ps(d1, d1, acc1);
+            }
+            float partial = hsum512f(_mm512_add_ps(acc0, acc1));
+            if (partial > bound) return partial;
+        }
+        for (; i + 16 <= n; i += 16) {
+            __m512 d = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+            acc0 = _mm512_fmadd_ps(d, d, acc0);
+        }
+        if (i < n) {
+            __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+            __m512 d = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i));
+            acc1 = _mm512_fmadd_ps(d, d, acc1);
+        }
+        return hsum512f(_mm512_add_ps(acc0, acc1));
+    }
+#endif
+};
+
+#endif
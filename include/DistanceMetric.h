@@ -0,0 +1,93 @@
+// DistanceMetric.h
+#ifndef DISTANCEMETRIC_H
+#define DISTANCEMETRIC_H
+
+#include "Distance.h"
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+
+//Rounding margin for covers derived from dot products
+constexpr double metricSlack = 1e-9;
+
+// Metric policies for BasicKDTree. A tree keeps its points in "stored"
+// coordinates (prepare() may rescale them, and returns the norm kept per
+// point) and prunes with euclidean geometry on those coordinates, so each
+// policy supplies:
+//   coverRadius:   a euclidean radius around the prepared query that contains
+//                  every stored point within radius (negative: none), with
+//                  slack where the key is computed another way than the bound;
+//   threshold/key: the exact test, key(row, query) <= threshold(radius),
+//                  where key may stop early once it passes the bound it gets;
+//   reported:      the value handed out as a "squared distance", the metric
+//                  distance d as d * |d|, so `<= radius * radius` keeps its
+//                  meaning for NeighborIndex even where d can go negative;
+//   radiusOf:      the radius whose threshold is a given key, to shrink the
+//                  cover while searching for a nearest point.
+// needsNorms says whether coverRadius uses the query norm and the largest
+// stored norm. Everything is static and inline, so the search loop is
+// specialized per metric with no virtual call per pair.
+
+//Euclidean distance; radius is a distance
+struct EuclideanMetric {
+    static constexpr bool rescales = false;
+    static constexpr bool needsNorms = false;
+    static double prepare(std::vector<double>& point) { return std::sqrt(Distance::dot(point.data(), point.data(), point.size())); }
+    static double coverRadius(double radius, double, double) { return radius; }
+    static double threshold(double radius) { return radius * radius; }
+    static double key(const double* row, const double* query, size_t n, double bound) { return Distance::squaredBounded(row, query, n, bound); }
+    static double reported(double key) { return key; }
+    static double radiusOf(double key) { return std::sqrt(key); }
+};
+
+//Squared euclidean distance; radius is a squared distance
+struct SquaredEuclideanMetric {
+    static constexpr bool rescales = false;
+    static constexpr bool needsNorms = false;
+    static double prepare(std::vector<double>& point) { return EuclideanMetric::prepare(point); }
+    static double coverRadius(double radius, double, double) { return radius >= 0.0 ? std::sqrt(radius) : -1.0; }
+    static double threshold(double radius) { return radius; }
+    static double key(const double* row, const double* query, size_t n, double bound) { return Distance::squaredBounded(row, query, n, bound); }
+    static double reported(double key) { return key * key; }
+    static double radiusOf(double key) { return key; }
+};
+
+// Cosine distance 1 - cos(a, b); radius is in [0, 2]. Points are stored as unit
+// vectors, so the test is one dot product, and |a - b|^2 = 2 (1 - cos) bounds
+// the euclidean search. A zero vector stays zero and is at distance 1 from all.
+struct CosineMetric {
+    static constexpr bool rescales = true;
+    static constexpr bool needsNorms = false;
+    static double prepare(std::vector<double>& point) {
+        double norm = std::sqrt(Distance::dot(point.data(), point.data(), point.size()));
+        if (norm > 0.0) {
+            for (double& x : point) x /= norm;
+        }
+        return norm;
+    }
+    static double coverRadius(double radius, double, double) { return radius >= 0.0 ? std::sqrt(2.0 * radius) + metricSlack : -1.0; }
+    static double threshold(double radius) { return radius; }
+    static double key(const double* row, const double* query, size_t n, double) { return 1.0 - Distance::dot(row, query, n); }
+    static double reported(double key) { return key * std::fabs(key); }
+    static double radiusOf(double key) { return key; }
+};
+
+// Inner-product distance 1 - a.b on the raw vectors (negative for a.b > 1).
+// a.b >= 1 - radius implies |a - b|^2 <= |a|^2 + |b|^2 - 2 (1 - radius), which
+// bounds the euclidean search with the query norm and the largest stored norm.
+struct InnerProductMetric {
+    static constexpr bool rescales = false;
+    static constexpr bool needsNorms = true;
+    static double prepare(std::vector<double>& point) { return EuclideanMetric::prepare(point); }
+    static double coverRadius(double radius, double queryNorm, double maxNorm) {
+        double coverSq = queryNorm * queryNorm + maxNorm * maxNorm - 2.0 * (1.0 - radius);
+        return coverSq >= -metricSlack ? std::sqrt(std::max(coverSq, 0.0)) + metricSlack : -1.0;
+    }
+    static double threshold(double radius) { return radius; }
+    static double key(const double* row, const double* query, size_t n, double) { return 1.0 - Distance::dot(row, query, n); }
+    static double reported(double key) { return key * std::fabs(key); }
+    static double radiusOf(double key) { return key; }
+};
+
+#endif
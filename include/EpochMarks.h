@@ -0,0 +1,45 @@
+// EpochMarks.h
+#ifndef EPOCHMARKS_H
+#define EPOCHMARKS_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+// Set over ids 0..n-1 that empties in O(1). Each id keeps the epoch in which it
+// was last inserted and reset() starts a new epoch, so a scratch set reused
+// across expansions needs no clearing pass and, once it has grown to the
+// largest n, no allocation. The stamps are only zeroed when the epoch wraps.
+class EpochMarks {
+public:
+    //Empty the set and make room for ids below n
+    void reset(size_t n) {
+        if (stamps.size() < n) stamps.resize(n, 0);
+        if (++epoch == 0) {
+            std::fill(stamps.begin(), stamps.end(), 0);
+            epoch = 1;
+        }
+    }
+
+    //Add id; false if it was already in the set
+    bool insert(int id) {
+        if (stamps[id] == epoch) return false;
+        stamps[id] = epoch;
+        return true;
+    }
+
+    bool contains(int id) const {
+        return stamps[id] == epoch;
+    }
+
+    size_t capacity() const {
+        return stamps.size();
+    }
+
+private:
+    std::vector<uint32_t> stamps;
+    uint32_t epoch = 0;
+};
+
+#endif
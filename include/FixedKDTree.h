@@ -0,0 +1,339 @@
+// FixedKDTree.h
+#ifndef FIXEDKDTREE_H
+#define FIXEDKDTREE_H
+
+#include "NeighborIndex.h"
+#include "Distance.h"
+#include "KDTree.h"
+#include "Metrics.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cmath>
+#include <functional>
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <stdexcept>
+
+// KD-tree for points of a dimension fixed at compile time. Each point is one
+// cache-line aligned row of Dim coordinates of type Scalar (float halves the
+// memory and bandwidth of double), kept in a vector indexed by id, and nodes
+// are 16-byte records in a pool linked by position, as in ArenaKDTree. When
+// the build targets AVX2 or wider (-march=native), distances use a loop with
+// the dimension as its trip count and fixed partial sums, which the compiler
+// unrolls and vectorizes inline, checking the bound once per block of four
+// vectors; otherwise they go to the runtime-dispatched Distance kernels,
+// which beat an SSE2-only inline loop. build() bulk loads with median
+// splits on the highest-spread axis; insert() descends to a leaf. Removed
+// points stay in the pool as tombstones that searches skip, so ids must not
+// be reused after removal. Queries arrive as double and are converted once.
+template <int Dim, typename Scalar = double>
+class FixedKDTree : public NeighborIndex {
+public:
+    static_assert(Dim > 0, "FixedKDTree needs a positive dimension");
+
+    struct alignas(64) Row {
+        Scalar x[Dim];
+    };
+
+    struct Node {
+        int32_t left;
+        int32_t right;
+        int32_t id;
+        int32_t axis;
+    };
+
+    static constexpr int32_t nil = -1;
+
+#if defined(__AVX2__)
+    static constexpr bool inlineKernel = true;
+#else
+    static constexpr bool inlineKernel = false;
+#endif
+
+    FixedKDTree() = default;
+
+    //Runtime-sized constructor, so the tree can stand in for KDTree(dimensions); dimensions must be Dim
+    explicit FixedKDTree(int dimensions) {
+        if (dimensions != Dim) throw std::invalid_argument("FixedKDTree<" + std::to_string(Dim) + ">: got " + std::to_string(dimensions) + " dimensions");
+    }
+
+    void reserve(size_t n) {
+        rows.reserve(n);
+        pool.reserve(n);
+    }
+
+    void insert(const std::vector<double>& point, int index) override {
+        store(point, index);
+        int32_t slot = static_cast<int32_t>(pool.size());
+        pool.push_back({nil, nil, index, 0});
+        if (root == nil) {
+            root = slot;
+        } else {
+            const Scalar* p = rows[index].x;
+            int32_t current = root;
+            int depth = 0;
+            while (true) {
+                Node& node = pool[current];
+                int32_t& next = p[node.axis] < rows[node.id].x[node.axis] ? node.left : node.right;
+                ++depth;
+                if (next == nil) {
+                    next = slot;
+                    pool[slot].axis = depth % Dim;
+                    break;
+                }
+                current = next;
+            }
+        }
+        pointInserted(index);
+    }
+
+    //Bulk load: add all points, then rebuild the whole pool with median splits on the highest-spread axis
+    void build(const std::vector<std::vector<double>>& points, int startIndex = 0) override {
+        std::vector<int32_t> ids;
+        ids.reserve(live + points.size());
+        for (const Node& node : pool) {
+            if (!removed[node.id]) ids.push_back(node.id);
+        }
+        for (size_t i = 0; i < points.size(); ++i) {
+            int id = startIndex + static_cast<int>(i);
+            store(points[i], id);
+            ids.push_back(id);
+        }
+        pool.clear();
+        pool.reserve(ids.size());
+        root = buildRec(ids, 0, ids.size());
+        pointsInserted(startIndex, static_cast<int>(points.size()));
+    }
+
+    void removeById(int id) override {
+        if (contains(id)) {
+            pointRemoving(id);
+            removed[id] = 1;
+            --live;
+        }
+    }
+
+    //Collect the ids (and optionally squared distances) of all points within radius of target
+    void radiusSearchIds(const std::vector<double>& target, double radius, std::vector<int>& ids, std::vector<double>* sqDistances = nullptr) const override {
+        METRIC_SCOPE(RadiusQuery);
+        METRIC_ADD(RadiusQueries, 1);
+        Row query{};
+        std::copy(target.begin(), target.begin() + std::min<size_t>(target.size(), Dim), query.x);
+        search(query.x, radius, ids, sqDistances);
+    }
+
+    //Nearest accepted point, searched near side first with the cover shrinking to the best distance found
+    int nearestWithin(const std::vector<double>& target, double radius, const std::function<bool(int)>& accept, double* sqDistance = nullptr) const override {
+        METRIC_SCOPE(RadiusQuery);
+        METRIC_ADD(RadiusQueries, 1);
+        Row query{};
+        std::copy(target.begin(), target.begin() + std::min<size_t>(target.size(), Dim), query.x);
+        Nearest nearest{-1, static_cast<Scalar>(radius * radius), static_cast<Scalar>(radius)};
+        if (radius >= 0.0) nearestRec(root, query.x, accept, nearest);
+        if (nearest.id >= 0 && sqDistance) *sqDistance = nearest.distSq;
+        return nearest.id;
+    }
+
+    //Radius search around a stored point, addressed by id
+    void radiusSearchById(int id, double radius, std::vector<int>& ids, std::vector<double>* sqDistances = nullptr) const override {
+        METRIC_SCOPE(RadiusQuery);
+        METRIC_ADD(RadiusQueries, 1);
+        if (!contains(id)) {
+            ids.clear();
+            if (sqDistances) sqDistances->clear();
+            return;
+        }
+        search(rows[id].x, radius, ids, sqDistances);
+    }
+
+    std::vector<double> getPoint(int id) const override {
+        if (!contains(id)) throw std::out_of_range("FixedKDTree: no point with id " + std::to_string(id));
+        return std::vector<double>(rows[id].x, rows[id].x + Dim);
+    }
+
+    const Scalar* pointData(int id) const {
+        return rows[id].x;
+    }
+
+    int size() const override {
+        return live;
+    }
+
+    //Bytes held by the rows and the node pool
+    size_t memoryUsage() const {
+        return rows.capacity() * sizeof(Row) + pool.capacity() * sizeof(Node);
+    }
+
+    //Squared distance between two rows; the partial sum once it passes bound after a block
+    static Scalar squaredBounded(const Scalar* a, const Scalar* b, Scalar bound) {
+        //One partial sum per lane of a 64-byte vector, a block is four vectors
+        constexpr int lanes = 64 / sizeof(Scalar);
+        constexpr int block = 4 * lanes;
+        Scalar sums[lanes] = {};
+        int d = 0;
+        for (; d + block <= Dim; d += block) {
+            for (int v = 0; v < block; v += lanes) {
+                for (int k = 0; k < lanes; ++k) {
+                    Scalar diff = a[d + v + k] - b[d + v + k];
+                    sums[k] += diff * diff;
+                }
+            }
+            if (d + block < Dim) {
+                Scalar partial = 0;
+                for (int k = 0; k < lanes; ++k) partial += sums[k];
+                if (partial > bound) return partial;
+            }
+        }
+        Scalar total = 0;
+        for (int k = 0; k < lanes; ++k) total += sums[k];
+        for (; d < Dim; ++d) {
+            Scalar diff = a[d] - b[d];
+            total += diff * diff;
+        }
+        return total;
+    }
+
+private:
+    std::vector<Row> rows;
+    std::vector<Node> pool;
+    std::vector<char> removed; // also 1 for ids never stored
+    int32_t root = nil;
+    int live = 0;
+
+    bool contains(int id) const {
+        return id >= 0 && id < static_cast<int>(removed.size()) && !removed[id];
+    }
+
+    void store(const std::vector<double>& point, int id) {
+        if (static_cast<int>(point.size()) != Dim) {
+            throw std::invalid_argument("FixedKDTree<" + std::to_string(Dim) + ">: point with " + std::to_string(point.size()) + " coordinates");
+        }
+        if (id >= static_cast<int>(rows.size())) {
+            rows.resize(id + 1);
+            removed.resize(id + 1, 1);
+        }
+        std::copy(point.begin(), point.end(), rows[id].x);
+        removed[id] = 0;
+        registerId(id);
+        ++live;
+    }
+
+    void search(const Scalar* target, double radius, std::vector<int>& ids, std::vector<double>* sqDistances) const {
+        ids.clear();
+        if (sqDistances) sqDistances->clear();
+        radiusSearchRec(root, target, static_cast<Scalar>(radius), static_cast<Scalar>(radius * radius), ids, sqDistances);
+    }
+
+    // Median split on the axis with the largest spread (estimated on a sample of the range); ties go right
+    int32_t buildRec(std::vector<int32_t>& ids, size_t begin, size_t end) {
+        if (begin >= end) return nil;
+
+        size_t count = end - begin;
+        size_t step = std::max<size_t>(1, count / 256);
+        int axis = 0;
+        Scalar bestSpread = -1;
+        for (int d = 0; d < Dim; ++d) {
+            Scalar lo = std::numeric_limits<Scalar>::infinity();
+            Scalar hi = -lo;
+            for (size_t i = begin; i < end; i += step) {
+                Scalar v = rows[ids[i]].x[d];
+                lo = std::min(lo, v);
+                hi = std::max(hi, v);
+            }
+            if (hi - lo > bestSpread) {
+                bestSpread = hi - lo;
+                axis = d;
+            }
+        }
+
+        auto less = [&](int32_t a, int32_t b) { return rows[a].x[axis] < rows[b].x[axis]; };
+        size_t mid = begin + count / 2;
+        std::nth_element(ids.begin() + begin, ids.begin() + mid, ids.begin() + end, less);
+        Scalar split = rows[ids[mid]].x[axis];
+        auto firstEqual = std::partition(ids.begin() + begin, ids.begin() + mid, [&](int32_t id) { return rows[id].x[axis] < split; });
+        std::iter_swap(firstEqual, ids.begin() + mid);
+        mid = firstEqual - ids.begin();
+
+        int32_t slot = static_cast<int32_t>(pool.size());
+        pool.push_back({nil, nil, ids[mid], axis});
+        int32_t left = buildRec(ids, begin, mid);
+        int32_t right = buildRec(ids, mid + 1, end);
+        pool[slot].left = left;
+        pool[slot].right = right;
+        return slot;
+    }
+
+    struct Nearest {
+        int id;
+        Scalar distSq; // best squared distance so far; radius squared until something is accepted
+        Scalar cover;  // its square root, how far from a splitting plane the far side is still searched
+    };
+
+    void nearestRec(int32_t current, const Scalar* target, const std::function<bool(int)>& accept, Nearest& nearest) const {
+        while (current != nil) {
+            const Node& node = pool[current];
+            const Scalar* p = rows[node.id].x;
+            METRIC_ADD(NodesVisited, 1);
+            METRIC_ADD(DistanceEvaluations, 1);
+            Scalar distSq = inlineKernel ? squaredBounded(p, target, nearest.distSq) : Distance::squaredBounded(p, target, Dim, nearest.distSq);
+            bool better = nearest.id < 0 ? distSq <= nearest.distSq : distSq < nearest.distSq || (distSq == nearest.distSq && node.id < nearest.id);
+            if (better && !removed[node.id] && accept(node.id)) {
+                nearest.id = node.id;
+                nearest.distSq = distSq;
+                nearest.cover = std::sqrt(distSq);
+            }
+
+            //Loop on the near side when the cover misses the far one, else recurse into the near side
+            //and loop on the far one if the cover, which may have shrunk meanwhile, still reaches it
+            Scalar offset = target[node.axis] - p[node.axis];
+            int32_t nearSide = offset < 0 ? node.left : node.right;
+            int32_t farSide = offset < 0 ? node.right : node.left;
+            if (farSide == nil || std::fabs(offset) > nearest.cover) {
+                current = nearSide;
+                continue;
+            }
+            if (nearSide != nil) nearestRec(nearSide, target, accept, nearest);
+            current = std::fabs(offset) <= nearest.cover ? farSide : nil;
+        }
+    }
+
+    void radiusSearchRec(int32_t current, const Scalar* target, Scalar radius, Scalar radiusSq, std::vector<int>& ids, std::vector<double>* sqDistances) const {
+        while (current != nil) {
+            const Node& node = pool[current];
+            const Scalar* p = rows[node.id].x;
+            METRIC_ADD(NodesVisited, 1);
+            METRIC_ADD(DistanceEvaluations, 1);
+            Scalar distSq = inlineKernel ? squaredBounded(p, target, radiusSq) : Distance::squaredBounded(p, target, Dim, radiusSq);
+            if (distSq <= radiusSq && !removed[node.id]) {
+                ids.push_back(node.id);
+                if (sqDistances) sqDistances->push_back(distSq);
+            }
+
+            //Recurse into one side, loop on the other
+            bool left = target[node.axis] - radius <= p[node.axis];
+            bool right = target[node.axis] + radius >= p[node.axis];
+            if (left && right) radiusSearchRec(node.left, target, radius, radiusSq, ids, sqDistances);
+            current = right ? node.right : left ? node.left : nil;
+        }
+    }
+};
+
+//The embedding widths in use
+using KDTree128 = FixedKDTree<128>;
+using KDTree256 = FixedKDTree<256>;
+using KDTree512 = FixedKDTree<512>;
+using FloatKDTree512 = FixedKDTree<512, float>;
+
+//A FixedKDTree when dimensions is one of the widths above, else the runtime-dimension KDTree
+inline std::unique_ptr<NeighborIndex> makeKDTree(int dimensions) {
+    switch (dimensions) {
+    case 128: return std::make_unique<KDTree128>();
+    case 256: return std::make_unique<KDTree256>();
+    case 512: return std::make_unique<KDTree512>();
+    default: return std::make_unique<KDTree>(dimensions);
+    }
+}
+
+#endif
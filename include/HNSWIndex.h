@@ -0,0 +1,269 @@
+// HNSWIndex.h
+#ifndef HNSWINDEX_H
+#define HNSWINDEX_H
+
+#include "NeighborIndex.h"
+#include "PointArena.h"
+#include "Distance.h"
+#include "Metrics.h"
+#include <vector>
+#include <queue>
+#include <random>
+#include <cmath>
+#include <unordered_set>
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+// Hierarchical navigable small world graph (Malkov & Yashunin) as an
+// approximate NeighborIndex backend for high-dimensional embeddings, where a
+// KD-tree prunes almost nothing. Points are inserted incrementally; removal
+// marks a tombstone so the point keeps routing searches but is never returned,
+// and ids must not be reused after removal.
+//
+// A radius query descends the upper layers greedily, runs a beam search of
+// width efSearch on the base layer, then floods the base-layer graph from
+// every candidate within rangeExpansion * radius, reporting those within
+// radius. Recall is below 1 when the eps-ball is poorly connected in the
+// graph; raise efSearch or rangeExpansion to trade speed for recall.
+class HNSWIndex : public NeighborIndex {
+public:
+    HNSWIndex(int dimensions, int M = 16, int efConstruction = 200, int efSearch = 64, unsigned seed = 42)
+        : dimensions(dimensions), M(M), maxM0(2 * M), efConstruction(efConstruction), efSearch(efSearch),
+          levelMult(1.0 / std::log(static_cast<double>(std::max(M, 2)))), arena(dimensions), rng(seed) {}
+
+    void setEfSearch(int ef) { efSearch = ef; }
+    void setRangeExpansion(double expansion) { rangeExpansion = expansion; }
+
+    void insert(const std::vector<double>& point, int index) override {
+        arena.set(index, point);
+        registerId(index);
+        if (index >= static_cast<int>(vertices.size())) {
+            vertices.resize(index + 1);
+            removed.resize(index + 1, 0);
+        }
+        std::uniform_real_distribution<double> unit(std::numeric_limits<double>::min(), 1.0);
+        int level = static_cast<int>(-std::log(unit(rng)) * levelMult);
+        vertices[index].level = level;
+        vertices[index].links.assign(level + 1, {});
+        removed[index] = 0;
+        ++live;
+
+        if (entryPoint < 0) {
+            entryPoint = index;
+            maxLevel = level;
+            pointInserted(index);
+            return;
+        }
+
+        const double* q = arena.row(index);
+        int ep = entryPoint;
+        for (int layer = maxLevel; layer > level; --layer) {
+            ep = greedyClosest(q, ep, layer);
+        }
+        std::vector<Candidate> entries{{distanceSq(q, ep), ep}};
+        for (int layer = std::min(level, maxLevel); layer >= 0; --layer) {
+            std::vector<Candidate> found = searchLayer(q, entries, efConstruction, layer);
+            std::vector<int>& links = vertices[index].links[layer];
+            links = selectNeighbors(found, M);
+            int maxLinks = layer == 0 ? maxM0 : M;
+            for (int neighbor : links) {
+                std::vector<int>& back = vertices[neighbor].links[layer];
+                back.push_back(index);
+                if (static_cast<int>(back.size()) > maxLinks) {
+                    shrinkLinks(neighbor, layer, maxLinks);
+                }
+            }
+            entries = std::move(found);
+        }
+        if (level > maxLevel) {
+            maxLevel = level;
+            entryPoint = index;
+        }
+        pointInserted(index);
+    }
+
+    void removeById(int id) override {
+        if (id >= 0 && id < static_cast<int>(removed.size()) && vertices[id].level >= 0 && !removed[id]) {
+            pointRemoving(id);
+            removed[id] = 1;
+            --live;
+        }
+    }
+
+    void radiusSearchIds(const std::vector<double>& target, double radius, std::vector<int>& ids, std::vector<double>* sqDistances = nullptr) const override {
+        ids.clear();
+        if (sqDistances) sqDistances->clear();
+        radiusSearchFrom(target.data(), radius, ids, sqDistances);
+    }
+
+    void radiusSearchById(int id, double radius, std::vector<int>& ids, std::vector<double>* sqDistances = nullptr) const override {
+        ids.clear();
+        if (sqDistances) sqDistances->clear();
+        if (id >= 0 && id < static_cast<int>(vertices.size()) && vertices[id].level >= 0 && !removed[id]) {
+            radiusSearchFrom(arena.row(id), radius, ids, sqDistances);
+        }
+    }
+
+    std::vector<double> getPoint(int id) const override {
+        return arena.point(id);
+    }
+
+    int size() const override {
+        return live;
+    }
+
+    bool isExact() const override {
+        return false;
+    }
+
+private:
+    struct Vertex {
+        int level = -1;
+        std::vector<std::vector<int>> links;
+    };
+
+    // Squared distance to the query and the vertex id
+    using Candidate = std::pair<double, int>;
+
+    int dimensions;
+    int M;
+    int maxM0;
+    int efConstruction;
+    int efSearch;
+    double levelMult;
+    double rangeExpansion = 1.0;
+    PointArena arena;
+    std::vector<Vertex> vertices;
+    std::vector<char> removed;
+    int entryPoint = -1;
+    int maxLevel = -1;
+    int live = 0;
+    std::mt19937 rng;
+
+    double distanceSq(const double* q, int id) const {
+        METRIC_ADD(DistanceEvaluations, 1);
+        return Distance::squared(q, arena.row(id), dimensions);
+    }
+
+    int greedyClosest(const double* q, int ep, int layer) const {
+        double best = distanceSq(q, ep);
+        bool improved = true;
+        while (improved) {
+            improved = false;
+            for (int neighbor : vertices[ep].links[layer]) {
+                double d = distanceSq(q, neighbor);
+                if (d < best) {
+                    best = d;
+                    ep = neighbor;
+                    improved = true;
+                }
+            }
+        }
+        return ep;
+    }
+
+    // Beam search of width ef on one layer; returns the closest candidates, nearest first
+    std::vector<Candidate> searchLayer(const double* q, const std::vector<Candidate>& entries, int ef, int layer) const {
+        std::unordered_set<int> seen;
+        std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> frontier;
+        std::priority_queue<Candidate> best;
+        for (const Candidate& entry : entries) {
+            if (seen.insert(entry.second).second) {
+                frontier.push(entry);
+                best.push(entry);
+                if (static_cast<int>(best.size()) > ef) best.pop();
+            }
+        }
+        while (!frontier.empty()) {
+            Candidate current = frontier.top();
+            if (static_cast<int>(best.size()) >= ef && current.first > best.top().first) break;
+            frontier.pop();
+            for (int neighbor : vertices[current.second].links[layer]) {
+                if (!seen.insert(neighbor).second) continue;
+                double d = distanceSq(q, neighbor);
+                if (static_cast<int>(best.size()) < ef || d < best.top().first) {
+                    frontier.push({d, neighbor});
+                    best.push({d, neighbor});
+                    if (static_cast<int>(best.size()) > ef) best.pop();
+                }
+            }
+        }
+        std::vector<Candidate> result(best.size());
+        for (size_t i = result.size(); i-- > 0;) {
+            result[i] = best.top();
+            best.pop();
+        }
+        return result;
+    }
+
+    // Neighbor selection heuristic: keep a candidate only if it is closer to the
+    // base point than to every neighbor already kept, then top up with the rest
+    std::vector<int> selectNeighbors(const std::vector<Candidate>& sorted, int m) const {
+        std::vector<int> kept;
+        std::vector<int> skipped;
+        for (const Candidate& candidate : sorted) {
+            if (static_cast<int>(kept.size()) >= m) break;
+            bool diverse = true;
+            for (int other : kept) {
+                if (distanceSq(arena.row(candidate.second), other) < candidate.first) {
+                    diverse = false;
+                    break;
+                }
+            }
+            (diverse ? kept : skipped).push_back(candidate.second);
+        }
+        for (size_t i = 0; i < skipped.size() && static_cast<int>(kept.size()) < m; ++i) {
+            kept.push_back(skipped[i]);
+        }
+        return kept;
+    }
+
+    void shrinkLinks(int id, int layer, int maxLinks) {
+        const double* base = arena.row(id);
+        std::vector<Candidate> candidates;
+        for (int neighbor : vertices[id].links[layer]) {
+            candidates.push_back({distanceSq(base, neighbor), neighbor});
+        }
+        std::sort(candidates.begin(), candidates.end());
+        vertices[id].links[layer] = selectNeighbors(candidates, maxLinks);
+    }
+
+    void radiusSearchFrom(const double* q, double radius, std::vector<int>& ids, std::vector<double>* sqDistances) const {
+        METRIC_SCOPE(RadiusQuery);
+        METRIC_ADD(RadiusQueries, 1);
+        if (entryPoint < 0) return;
+
+        int ep = entryPoint;
+        for (int layer = maxLevel; layer > 0; --layer) {
+            ep = greedyClosest(q, ep, layer);
+        }
+        std::vector<Candidate> found = searchLayer(q, {{distanceSq(q, ep), ep}}, efSearch, 0);
+
+        double radiusSq = radius * radius;
+        double floodSq = radiusSq * rangeExpansion * rangeExpansion;
+        std::unordered_set<int> seen;
+        std::vector<int> queue;
+        auto visit = [&](int id, double d) {
+            if (d > floodSq) return;
+            queue.push_back(id);
+            if (d <= radiusSq && !removed[id]) {
+                ids.push_back(id);
+                if (sqDistances) sqDistances->push_back(d);
+            }
+        };
+        for (const Candidate& candidate : found) {
+            seen.insert(candidate.second);
+            visit(candidate.second, candidate.first);
+        }
+        for (size_t head = 0; head < queue.size(); ++head) {
+            for (int neighbor : vertices[queue[head]].links[0]) {
+                if (seen.insert(neighbor).second) {
+                    visit(neighbor, distanceSq(q, neighbor));
+                }
+            }
+        }
+    }
+};
+
+#endif
@@ -1,52 +1,64 @@
 #ifndef INCDBSCAN_H
 #define INCDBSCAN_H
 
+#include "NeighborIndex.h"
 #include "KDTree.h"
+#include "Metrics.h"
+#include "LabelSnapshots.h"
+#include "ParallelFor.h"
+#include "EpochMarks.h"
 #include <vector>
-#include <unordered_map>
-#include <unordered_set>
 #include <cmath>
 #include <functional>
 #include <algorithm>
-#include <stack>
+#include <limits>
+#include <iostream>
 #include <chrono>
 class INCDBSCAN {
 public:
-    INCDBSCAN(double eps, int minPts, KDTree& kdTree)
-        : eps(eps), minPts(minPts), kdTree(kdTree) {}
+    INCDBSCAN(double eps, int minPts, NeighborIndex& searchIndex)
+        : eps(eps), minPts(minPts), searchIndex(searchIndex) {}
 
     void cluster(const std::vector<std::vector<double>>& points, int nextClusterId, int startingIndex) {
+        METRIC_SCOPE(INCDBSCANBatch);
         this->nextClusterId = nextClusterId;
         this->startingIndex = startingIndex;
-        std::cout << "Starting INCDBSCAN with clusterID " << nextClusterId << " startingIndex " << startingIndex << std::endl;
+        bool log = Metrics::logging();
+        if (log) std::cout << "Starting INCDBSCAN with clusterID " << nextClusterId << " startingIndex " << startingIndex << std::endl;
         // Initialize all points as not visited
-        visited.assign(points.size() + startingIndex, false);
+        visited.reset(points.size() + startingIndex);
         
 
         //Benchmark the time taken to insert all the points into the KDTree
         auto start = std::chrono::high_resolution_clock::now();
-        for (size_t i = 0; i < points.size(); ++i) {
-            kdTree.insert(points[i], i+startingIndex);
+        if (searchIndex.batchQueries()) {
+            //Batch backends load the whole batch and count and cache its eps-neighborhoods in one pass
+            searchIndex.trackNeighborCounts(eps);
+            searchIndex.build(points, startingIndex);
+        } else {
+            for (size_t i = 0; i < points.size(); ++i) {
+                searchIndex.insert(points[i], i+startingIndex);
+            }
         }
-        std::cout << "KDTree size: " << kdTree.size() << std::endl;
+        if (log) std::cout << "Index size: " << searchIndex.size() << std::endl;
     
         auto end = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
         double durationInSeconds = duration / 1e6; // Convert microseconds to seconds
-        std::cout << "Time taken to insert all the points into the KDTree: " << durationInSeconds << " seconds" << std::endl;
+        if (log) std::cout << "Time taken to insert all the points into the KDTree: " << durationInSeconds << " seconds" << std::endl;
         
         //Call insertPoint for each point with index
         start = std::chrono::high_resolution_clock::now();
-        std::cout << "Newly added points size : " << points.size() << std::endl;
+        if (log) std::cout << "Newly added points size : " << points.size() << std::endl;
         for (int i = 0; i < points.size(); i++) {
-            if (!visited[i + startingIndex]) {
-                insertPoint(points[i], i + startingIndex);
+            if (!visited.contains(i + startingIndex)) {
+                insertPoint(i + startingIndex);
             }
         }
         end = std::chrono::high_resolution_clock::now();
         duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
         durationInSeconds = duration / 1e6; // Convert microseconds to seconds
-        std::cout << "Time taken to call insertPoint for each point: " << durationInSeconds << " seconds" << std::endl;
+        if (log) std::cout << "Time taken to call insertPoint for each point: " << durationInSeconds << " seconds" << std::endl;
         
         // //Update the cluster ID of the points in the KDTree
         // for(int i = 0; i < points.size(); i++){
@@ -54,40 +66,143 @@ public:
         //     kdTree.assignClusterID(points[i], clusterID);
         // }
         
-        //Sort the pairs of merge_cluster_pairs
-        std::sort(merge_cluster_pairs.begin(), merge_cluster_pairs.end());
-        //Optimize the merge_cluster_pairs by removing the duplicate pairs
-        std::unordered_map<int, int> cleaned_merges;
-
-        // Iterate through merge pairs and keep track of the last conversion
-        for (const auto& merge_cluster_pair : merge_cluster_pairs) {
-            cleaned_merges[merge_cluster_pair.first] = merge_cluster_pair.second;
-        }
-        // merge_cluster_pairs.erase(std::unique(merge_cluster_pairs.begin(), merge_cluster_pairs.end()), merge_cluster_pairs.end());
-        //Benchmark the time taken to merge the clusters
-        start = std::chrono::high_resolution_clock::now();
-        for (const auto& pair : cleaned_merges) {
-            std::cout << "Merging clusters " << pair.first << " to " << pair.second << std::endl;
-            kdTree.mergeClusters(pair.first, pair.second);
+        //Merges were applied as unions while expanding; labels resolve through the disjoint-set
+        if (log) {
+            std::cout << "Merged " << mergeCount << " cluster pairs" << std::endl;
+            NeighborhoodCache::Stats cache = searchIndex.cacheStats();
+            std::cout << "Neighborhood cache: " << cache.entries << " entries, " << cache.bytes << " bytes, " << cache.hits << " hits, "
+                      << cache.misses << " misses, " << cache.evictions << " evictions, " << cache.invalidations << " invalidations" << std::endl;
         }
-        end = std::chrono::high_resolution_clock::now();
-        duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-        durationInSeconds = duration / 1e6; // Convert microseconds to seconds
-        std::cout << "Time taken to merge the clusters: " << durationInSeconds << " seconds" << std::endl;
-        
-        
+        mergeCount = 0;
+        if (snapshots) snapshots->publish(searchIndex);
+    }
+
+    //Publish the labels to snapshots after every batch and removal, for readers running alongside
+    void publishTo(LabelSnapshots* snapshots) {
+        this->snapshots = snapshots;
     }
 
+    //Renumber the live clusters to 0..k-1 so ids freed by merges are reused
+    void compactLabels() {
+        nextClusterId = searchIndex.compactClusterIds();
+        if (snapshots) snapshots->publish(searchIndex);
+    }
     
-    void insertPoint(const std::vector<double>& point, int index) {
-        
-        // Step 1.1: Find neighborhood of current new point
+    //Remove one stored point and repair the clustering around it
+    void removePoint(int id) {
+        removePoints(std::vector<int>{id});
+    }
+
+    // Remove stored points and repair the clustering locally. Neighbors whose
+    // count drops below minPts are demoted; core points next to a removed core
+    // or a demoted point seed a search for a split. Each seed floods the core
+    // points density-reachable from it, one step per seed in turn, and floods
+    // that meet are joined. The search stops as soon as a single flood is left
+    // running: every flood that ran dry before meeting the others is a piece
+    // that split off and gets a new cluster id, and the rest keep the old one.
+    // Floods only cross cores of the seeds' own cluster, so a removal never
+    // merges clusters or relabels one it only touches. Labeled non-core points
+    // near the changes keep their cluster if a core of it still reaches them,
+    // else take a piece it split into, else become noise; as on insertion, a
+    // point without a label never gets one.
+    void removePoints(const std::vector<int>& ids) {
+        METRIC_SCOPE(RemovePoints);
         auto start = std::chrono::high_resolution_clock::now();
-        auto neighbors = kdTree.radiusSearchUsingCache(point, eps);
+        nextClusterId = std::max(nextClusterId, searchIndex.clusterIdBound());
+
+        //Scratch kept across calls: epoch-stamped id sets and flat lists instead of hash containers
+        RemovalScratch& s = removal;
+        int bound = searchIndex.idBound();
+        s.removed.reset(bound);
+        s.seedMarks.reset(bound);
+        s.borderMarks.reset(bound);
+        if (static_cast<int>(s.lost.size()) < bound) s.lost.resize(bound, 0);
+        s.removedIds.clear();
+        s.lostIds.clear();
+        s.aroundCores.clear();
+        s.seeds.clear();
+        s.borders.clear();
+        s.demoted.clear();
+        s.pieces.clear();
+        std::vector<int>& neighbors = s.neighbors;
+
+        //Neighborhoods before removal, and how many neighbors each survivor loses
+        for (int id : ids) {
+            if (id >= 0 && id < bound && s.removed.insert(id)) s.removedIds.push_back(id);
+        }
+        for (int id : s.removedIds) {
+            searchIndex.radiusSearchById(id, eps, neighbors);
+            if (neighbors.empty()) continue; // not stored
+            if (static_cast<int>(neighbors.size()) >= minPts) s.aroundCores.insert(s.aroundCores.end(), neighbors.begin(), neighbors.end());
+            for (int neighbor : neighbors) {
+                if (!s.removed.contains(neighbor) && s.lost[neighbor]++ == 0) s.lostIds.push_back(neighbor);
+            }
+        }
+        for (int id : s.removedIds) {
+            searchIndex.removeById(id);
+            searchIndex.assignClusterIdById(id, -1);
+        }
+
+        //Survivors that were core before and are not any more
+        for (int id : s.lostIds) {
+            int count = neighborCount(id);
+            if (count < minPts && count + s.lost[id] >= minPts) s.demoted.push_back(id);
+        }
+
+        //Cores next to a lost core seed the split search; non-cores there need their border label checked
+        for (int id : s.demoted) addBorder(id);
+        auto collect = [&](const std::vector<int>& around) {
+            for (int neighbor : around) {
+                if (s.removed.contains(neighbor)) continue;
+                if (neighborCount(neighbor) < minPts) addBorder(neighbor);
+                else if (s.seedMarks.insert(neighbor)) s.seeds.push_back(neighbor);
+            }
+        };
+        collect(s.aroundCores);
+        for (int id : s.demoted) {
+            searchIndex.radiusSearchByIdUsingCache(id, eps, neighbors);
+            collect(neighbors);
+        }
+        for (int id : s.lostIds) {
+            if (neighborCount(id) < minPts) addBorder(id);
+            s.lost[id] = 0;
+        }
+
+        //Split search per cluster the seeds belong to, in cluster order, seeds in id order; unlabeled cores have none
+        std::vector<std::pair<int, int>>& byCluster = s.seedsByCluster;
+        byCluster.clear();
+        for (int seed : s.seeds) {
+            int label = searchIndex.getClusterIdById(seed);
+            if (label >= 0) byCluster.push_back({label, seed});
+        }
+        std::sort(byCluster.begin(), byCluster.end());
+        int splits = 0;
+        for (size_t first = 0, last = 0; first < byCluster.size(); first = last) {
+            s.group.clear();
+            for (last = first; last < byCluster.size() && byCluster[last].first == byCluster[first].first; ++last) s.group.push_back(byCluster[last].second);
+            splits += splitCluster(s.group, byCluster[first].first);
+        }
+
+        for (int id : s.borders) relabelBorder(id);
+
         auto end = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
         double durationInSeconds = duration / 1e6; // Convert microseconds to seconds
-        // std::cout << "Time taken to find neighbors for index " << index << " : " << durationInSeconds << " seconds" << std::endl;
+        METRIC_ADD(PointsRemoved, s.removedIds.size());
+        METRIC_ADD(ClusterSplits, splits);
+        if (Metrics::logging()) {
+            std::cout << "Removed " << s.removedIds.size() << " points, demoted " << s.demoted.size() << " core points, "
+                      << splits << " clusters split off in " << durationInSeconds << " seconds" << std::endl;
+        }
+        if (snapshots) snapshots->publish(searchIndex);
+    }
+
+    void insertPoint(int index) {
+        METRIC_SCOPE(InsertPoint);
+        
+        // Step 1.1: Find neighborhood of current new point
+        std::vector<int>& neighbors = insertNeighbors;
+        searchIndex.radiusSearchByIdUsingCache(index, eps, neighbors);
 
         // Debug
         // std::cout << "Found " << neighbors.size() << " neighbors." << " for index " << index << std::endl;
@@ -95,129 +210,92 @@ public:
         // Step 1.2: Check current point is core point or not
         if(neighbors.size() < minPts){
             //Assign noise to the current point
-            kdTree.assignClusterID(point, -1);
-            visited[index] = true;
+            searchIndex.assignClusterIdById(index, -1);
+            visited.insert(index);
+            METRIC_ADD(InsertNoise, 1);
             return;
         }
-        // Step 1.3: Get all the cluster IDs of each of the neighbors
-        // start = std::chrono::high_resolution_clock::now();
-        std::set<int> labels_of_neighbors;
+        // Step 1.3: Get the cluster IDs of the neighbors; only none, one, or several matters
+        int firstLabel = -1;
+        bool severalLabels = false;
         for(auto neighbor : neighbors){
-            int label = kdTree.getClusterId(neighbor);
+            int label = searchIndex.getClusterIdById(neighbor);
             //TODO: Done
             if(label != -1){
-                labels_of_neighbors.insert(label);
+                if (firstLabel == -1) firstLabel = label;
+                else if (label != firstLabel) severalLabels = true;
             }
         }
-        // end = std::chrono::high_resolution_clock::now();
-        // duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-        // durationInSeconds = duration / 1e6; // Convert microseconds to seconds
-        // std::cout << "Time taken to get labels of core points: " << durationInSeconds << " seconds" << std::endl;
-        // Debug
-        // std::cout << "Labels of core points: " << labels_of_neighbors.size() << std::endl;
-        // for(auto label : labels_of_neighbors){
-        //     std::cout << " Label: " << label;
-        // }
-        // std::cout << std::endl;
         // Step 1.4: If none of the core point is labeled
-        if(labels_of_neighbors.size() == 0){
+        if(firstLabel == -1){
             // Debug
             // std::cout << "No labeled core points found, creating a new cluster" << std::endl;
-            start = std::chrono::high_resolution_clock::now();
-            modified_expandCluster(point, index, nextClusterId++);
-            end = std::chrono::high_resolution_clock::now();
-            duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-            durationInSeconds = duration / 1e6; // Convert microseconds to seconds
-            std::cout << "Time taken to expand cluster CASE A: " << durationInSeconds << " seconds" << std::endl;
+            METRIC_ADD(InsertNewCluster, 1);
+            modified_expandCluster(index, nextClusterId++);
         }
 
         // Step 1.5: If all the core points are labeled
-        else if(labels_of_neighbors.size() == 1){
+        else if(!severalLabels){
             // Debug
             // std::cout << "All labeled core points found, assigning to the existing cluster" << std::endl;
-            start = std::chrono::high_resolution_clock::now();
-            modified_expandCluster(point, index, *labels_of_neighbors.begin());
-            end = std::chrono::high_resolution_clock::now();
-            duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-            durationInSeconds = duration / 1e6; // Convert microseconds to seconds
-            std::cout << "Time taken to expand cluster CASE B: " << durationInSeconds << " seconds" << std::endl;
+            METRIC_ADD(InsertJoinCluster, 1);
+            modified_expandCluster(index, firstLabel);
         }
 
         // Step 1.6: If the core points are labeled differently
-        else if(labels_of_neighbors.size() > 1){
+        else{
             // Debug
             // std::cout << "Multiple labeled core points found, merging the clusters" << std::endl;
-            start = std::chrono::high_resolution_clock::now();
-            modified_expandCluster(point, index, nextClusterId++);
-            end = std::chrono::high_resolution_clock::now();
-            duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-            durationInSeconds = duration / 1e6; // Convert microseconds to seconds
-            std::cout << "Time taken to expand cluster CASE C: " << durationInSeconds << " seconds" << std::endl;
+            METRIC_ADD(InsertMergeClusters, 1);
+            modified_expandCluster(index, nextClusterId++);
         }
 
     }
 
-    void modified_expandCluster(const std::vector<double>& currentPoint, int index, int clusterID) {
-        std::stack<std::pair<std::vector<double>, int>> dfsStack;
-        std::vector<std::pair<std::vector<double>, int>> dfsPath;
-        std::unordered_set<int> visiteddfsPoints;
-        std::unordered_set<int> uniqueLabels;
+    void modified_expandCluster(int index, int clusterID) {
+        //Scratch kept across calls: flat stack and path, epoch-stamped membership, no allocation once grown
+        std::vector<int>& dfsStack = scratch.stack;
+        std::vector<int>& dfsPath = scratch.path;
+        std::vector<int>& uniqueLabels = scratch.labels;
+        std::vector<int>& neighbors = scratch.neighbors;
+        EpochMarks& onPath = scratch.onPath;
+        EpochMarks& seenLabels = scratch.seenLabels;
+        dfsStack.clear();
+        dfsPath.clear();
+        uniqueLabels.clear();
+        onPath.reset(visited.capacity());
+        seenLabels.reset(searchIndex.clusterIdBound());
         
-        dfsStack.push({currentPoint, index});
+        dfsStack.push_back(index);
 
         while (!dfsStack.empty()) {
-            auto [point, currentIndex] = dfsStack.top();
-            dfsStack.pop();
-            if (!visited[currentIndex]) {
-                visited[currentIndex] = true;
-                
-                auto neighbors = kdTree.radiusSearchUsingCache(point, eps);
+            int currentIndex = dfsStack.back();
+            dfsStack.pop_back();
+            if (visited.insert(currentIndex)) {
+                searchIndex.radiusSearchByIdUsingCache(currentIndex, eps, neighbors);
                 
                 if (neighbors.size() >= minPts) {
-                    dfsPath.push_back({currentPoint,currentIndex});
                     // Current point is a core point
-                    for (const auto& neighbor : neighbors) {
-                        auto neighbors_of_neighbor = kdTree.radiusSearchUsingCache(neighbor, eps);
-                        if(neighbors_of_neighbor.size() >= minPts){
+                    if (onPath.insert(currentIndex)) dfsPath.push_back(currentIndex);
+                    for (int neighborIndex : neighbors) {
+                        if(searchIndex.isCore(neighborIndex, eps, minPts)){
                             // Neighbor is a core point
-                            int neighborIndex = kdTree.getIndex(neighbor);
-                            int neighborClusterID = kdTree.getClusterId(neighbor);
+                            int neighborClusterID = searchIndex.getClusterIdById(neighborIndex);
                             if(neighborClusterID != -1){
-                                uniqueLabels.insert(neighborClusterID);
+                                if (seenLabels.insert(neighborClusterID)) uniqueLabels.push_back(neighborClusterID);
                             }
-                            else{
-                                if(!visited[neighborIndex]){
-                                    if(visiteddfsPoints.find(neighborIndex) == visiteddfsPoints.end()){
-                                        dfsStack.push({neighbor, neighborIndex});
-                                        dfsPath.push_back({neighbor, neighborIndex});
-                                        visiteddfsPoints.insert(neighborIndex);
-                                    }
-                                }
+                            else if(!visited.contains(neighborIndex) && onPath.insert(neighborIndex)){
+                                dfsStack.push_back(neighborIndex);
+                                dfsPath.push_back(neighborIndex);
                             }
                         }
-                        else{
-                            // Neighbor is a border point
-                            //Do nothing
-                        }
+                        // Border neighbors are left alone
                     }
                 }
-                else{
-                    // Current point is a border point
-                    // Do nothing
-                }
-                
+                // A border point ends this branch
             }
         }
 
-        //Debug
-        if(uniqueLabels.size() != 0){
-            std::cout << "Unique labels for index "  << index <<" and incoming clusterid " << clusterID << " : " << uniqueLabels.size() << std::endl;
-            for(auto label : uniqueLabels){
-                std::cout << " Label: " << label;
-            }
-            std::cout << std::endl;
-        }
-        
         // Determine the cluster ID to assign
         int assignClusterID;
         if (uniqueLabels.empty()) {
@@ -225,18 +303,20 @@ public:
             assignClusterID = clusterID;
         } else if (uniqueLabels.size() == 1) {
             // Case 1: Only one unique label encountered
-            assignClusterID = *uniqueLabels.begin();
+            assignClusterID = uniqueLabels.front();
         } else {
             // Case 2: Multiple labels encountered, all labels should merge to the new cluster
             assignClusterID = clusterID;
-            for (auto it = uniqueLabels.begin(); it != uniqueLabels.end(); ++it) {
-                merge_cluster_pairs.emplace_back(*it, assignClusterID);
+            for (auto it = uniqueLabels.rbegin(); it != uniqueLabels.rend(); ++it) {
+                assignClusterID = searchIndex.mergeClusters(*it, assignClusterID);
+                ++mergeCount;
+                METRIC_ADD(ClusterMerges, 1);
             }
         }
         
         // Assign the determined cluster ID to all points in the DFS path
-        for (auto path : dfsPath) {
-            kdTree.updateClusterId(path.first, assignClusterID);
+        for (int pathIndex : dfsPath) {
+            searchIndex.assignClusterIdById(pathIndex, assignClusterID);
         }
     }
 
@@ -244,26 +324,238 @@ public:
         clusterId = nextClusterId;
     }
 
+    //Labels of every stored id (clusterIds[id], -1 for noise) and the next free cluster id
     void getClustersLabels(std::vector<int>& clusterIds, int& clusterID) {
-        clusterIds.clear();
-        clusterIds.reserve(clusters.size());
-        //Take values from startIndex
-        for (int i = 0/*startingIndex*/; i < clusters.size(); ++i) {
-            clusterIds.push_back(clusters[i]);
-        }
+        searchIndex.clusterLabels(clusterIds);
         clusterID = nextClusterId;
     }
 
+    //Labels of ids first..last-1 only
+    void getClustersLabels(std::vector<int>& clusterIds, int first, int last) {
+        searchIndex.clusterLabels(clusterIds, first, last);
+    }
+
+    // Where a query point would belong, without inserting it: the cluster of the
+    // nearest labeled core point within eps, or -1 (noise). Only reads the index
+    // (no visited flags, cache or counts change), so any number of threads may
+    // predict at once, though not while a batch or removal runs. Core status comes
+    // from the counts the index already keeps; a point without one is counted with
+    // a search. The KD-trees look for the nearest such point directly, pruning as
+    // it gets nearer, and scratch buffers are per thread, so calls do not allocate.
+    struct Assignment {
+        int label = -1;
+        int nearestCore = -1; // id of the core point the label came from
+        double distance = std::numeric_limits<double>::infinity();
+    };
+
+    Assignment predict(const std::vector<double>& point) const {
+        METRIC_SCOPE(Predict);
+        const NeighborIndex& index = searchIndex;
+        double sqDistance = 0.0;
+        int core = index.nearestWithin(point, eps, [this](int id) { return searchIndex.getClusterIdById(id) >= 0 && isCoreReadOnly(id); }, &sqDistance);
+        Assignment assignment;
+        if (core < 0) return assignment;
+        assignment.label = index.getClusterIdById(core);
+        assignment.nearestCore = core;
+        //Squared distances are reported as d * |d|
+        assignment.distance = sqDistance >= 0.0 ? std::sqrt(sqDistance) : -std::sqrt(-sqDistance);
+        return assignment;
+    }
+
+    //predict() for each point, on threads threads (0: all hardware threads)
+    void predict(const std::vector<std::vector<double>>& points, std::vector<Assignment>& assignments, int threads = 1) const {
+        assignments.resize(points.size());
+        parallelFor(resolveThreadCount(threads), points.size(), 64, [&](size_t i) { assignments[i] = predict(points[i]); });
+    }
+
 
 private:
     double eps;
     int minPts;
-    KDTree& kdTree;
-    std::vector<bool> visited;
-    std::vector<int> clusters;
-    int nextClusterId;
-    int startingIndex;
-    std::vector<std::pair<int, int>> merge_cluster_pairs;
+    NeighborIndex& searchIndex;
+    //Ids handled in the current batch
+    EpochMarks visited;
+    std::vector<int> insertNeighbors;
+    // Buffers modified_expandCluster reuses from call to call
+    struct ExpansionScratch {
+        std::vector<int> stack;
+        std::vector<int> path;
+        std::vector<int> labels;
+        std::vector<int> neighbors;
+        EpochMarks onPath;
+        EpochMarks seenLabels;
+    };
+    ExpansionScratch scratch;
+    // Buffers removePoints and its helpers reuse from call to call
+    struct RemovalScratch {
+        EpochMarks removed;
+        EpochMarks seedMarks;
+        EpochMarks borderMarks;
+        EpochMarks owned;
+        std::vector<int> removedIds;
+        std::vector<int> lost; // per id, back to 0 after each call
+        std::vector<int> lostIds;
+        std::vector<int> aroundCores;
+        std::vector<int> demoted;
+        std::vector<int> seeds;
+        std::vector<int> borders;
+        std::vector<std::pair<int, int>> seedsByCluster;
+        std::vector<int> group;
+        std::vector<std::pair<int, int>> pieces; // (new cluster id, cluster it split from)
+        std::vector<int> neighbors;
+        //splitCluster's floods: union-find parents, frontier and members per flood, the floods still running
+        std::vector<int> owner;
+        std::vector<int> parent;
+        std::vector<std::vector<int>> frontier;
+        std::vector<std::vector<int>> members;
+        std::vector<int> running;
+        std::vector<int> next;
+    };
+    RemovalScratch removal;
+    int nextClusterId = 0;
+    int startingIndex = 0;
+    int mergeCount = 0;
+    LabelSnapshots* snapshots = nullptr;
+
+    int neighborCount(int id) {
+        return searchIndex.neighborCount(id, eps);
+    }
+
+    bool isCoreReadOnly(int id) const {
+        int count = searchIndex.knownNeighborCount(id, eps);
+        if (count < 0) {
+            thread_local std::vector<int> around;
+            searchIndex.radiusSearchById(id, eps, around);
+            count = static_cast<int>(around.size());
+        }
+        return count >= minPts;
+    }
+
+    //Queue a non-core point near a removal for relabelBorder, once
+    void addBorder(int id) {
+        if (removal.borderMarks.insert(id)) removal.borders.push_back(id);
+    }
+
+    //Flood the cores of cluster label reachable from each seed until one flood is left; returns the pieces split off
+    int splitCluster(const std::vector<int>& seeds, int label) {
+        if (seeds.size() < 2) return 0;
+        //Floods that meet are joined in a small union-find; frontier and members live at the root
+        int count = static_cast<int>(seeds.size());
+        std::vector<int>& parent = removal.parent;
+        std::vector<std::vector<int>>& frontier = removal.frontier;
+        std::vector<std::vector<int>>& members = removal.members;
+        std::vector<int>& running = removal.running;
+        std::vector<int>& next = removal.next;
+        parent.resize(count);
+        running.resize(count);
+        if (static_cast<int>(frontier.size()) < count) {
+            frontier.resize(count);
+            members.resize(count);
+        }
+        //Flood owning each reached core, valid where owned is set
+        EpochMarks& owned = removal.owned;
+        std::vector<int>& owner = removal.owner;
+        owned.reset(searchIndex.idBound());
+        if (owner.size() < owned.capacity()) owner.resize(owned.capacity());
+        for (int flood = 0; flood < count; ++flood) {
+            parent[flood] = flood;
+            frontier[flood].assign(1, seeds[flood]);
+            members[flood].assign(1, seeds[flood]);
+            owned.insert(seeds[flood]);
+            owner[seeds[flood]] = flood;
+            running[flood] = flood;
+        }
+        auto find = [&](int flood) {
+            while (parent[flood] != flood) flood = parent[flood] = parent[parent[flood]];
+            return flood;
+        };
+        auto join = [&](int a, int b) {
+            if (members[a].size() < members[b].size()) std::swap(a, b);
+            parent[b] = a;
+            frontier[a].insert(frontier[a].end(), frontier[b].begin(), frontier[b].end());
+            members[a].insert(members[a].end(), members[b].begin(), members[b].end());
+            frontier[b].clear();
+            members[b].clear();
+            return a;
+        };
+
+        int splits = 0;
+        std::vector<int>& neighbors = removal.neighbors;
+        while (running.size() > 1) {
+            next.clear();
+            for (size_t r = 0; r < running.size(); ++r) {
+                int flood = find(running[r]);
+                if (std::find(next.begin(), next.end(), flood) != next.end()) continue;
+                if (frontier[flood].empty()) {
+                    //Ran dry before meeting the others: a separate piece, unless no other flood is left
+                    bool others = false;
+                    for (int f : next) others = others || find(f) != flood;
+                    for (size_t k = r + 1; k < running.size(); ++k) others = others || find(running[k]) != flood;
+                    if (!others) {
+                        next.push_back(flood);
+                        continue;
+                    }
+                    int pieceID = nextClusterId++;
+                    removal.pieces.push_back({pieceID, label});
+                    for (int member : members[flood]) {
+                        searchIndex.assignClusterIdById(member, pieceID);
+                        searchIndex.radiusSearchByIdUsingCache(member, eps, neighbors);
+                        for (int neighbor : neighbors) {
+                            if (!owned.contains(neighbor)) addBorder(neighbor);
+                        }
+                    }
+                    ++splits;
+                    continue;
+                }
+                //One step: expand a frontier core to its core neighbors
+                int current = frontier[flood].back();
+                frontier[flood].pop_back();
+                searchIndex.radiusSearchByIdUsingCache(current, eps, neighbors);
+                for (int neighbor : neighbors) {
+                    if (neighborCount(neighbor) < minPts || searchIndex.getClusterIdById(neighbor) != label) continue;
+                    if (owned.insert(neighbor)) {
+                        owner[neighbor] = flood;
+                        frontier[flood].push_back(neighbor);
+                        members[flood].push_back(neighbor);
+                    } else if (find(owner[neighbor]) != flood) {
+                        flood = join(flood, find(owner[neighbor]));
+                    }
+                }
+                next.push_back(flood);
+            }
+            running.clear();
+            for (int flood : next) {
+                flood = find(flood);
+                if (std::find(running.begin(), running.end(), flood) == running.end()) running.push_back(flood);
+            }
+        }
+        return splits;
+    }
+
+    //Keep a labeled non-core point in its cluster if a core of it still reaches it, else move it to the
+    //piece of its lowest core neighbor that split off that cluster, else make it noise; noise stays noise
+    void relabelBorder(int id) {
+        int current = searchIndex.getClusterIdById(id);
+        if (current < 0) return;
+        std::vector<int>& neighbors = removal.neighbors;
+        searchIndex.radiusSearchByIdUsingCache(id, eps, neighbors);
+        if (neighbors.empty() || static_cast<int>(neighbors.size()) >= minPts) return; // removed, or core
+        int fallback = -1;
+        int fallbackId = -1;
+        for (int neighbor : neighbors) {
+            if (neighbor == id || neighborCount(neighbor) < minPts) continue;
+            int label = searchIndex.getClusterIdById(neighbor);
+            if (label == current) return;
+            if (fallbackId >= 0 && neighbor > fallbackId) continue;
+            for (const auto& piece : removal.pieces) {
+                if (piece.first == label && piece.second == current) {
+                    fallbackId = neighbor;
+                    fallback = label;
+                }
+            }
+        }
+        searchIndex.assignClusterIdById(id, fallback);
+    }
     
 
 };
@@ -2,219 +2,454 @@
 #ifndef KDTREE_H
 #define KDTREE_H
 
+#include "Distance.h"
+#include "DistanceMetric.h"
+#include "NeighborIndex.h"
+#include "Metrics.h"
 #include <iostream>
 #include <vector>
 #include <memory>
 #include <algorithm>
 #include <cmath>
 #include <limits>
-
-struct VectorHash {
-    std::size_t operator()(const std::pair<std::vector<double>, double>& key) const {
-        std::size_t seed = 0;
-        for (double i : key.first) {
-            seed ^= std::hash<double>()(i) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-        }
-        seed ^= std::hash<double>()(key.second) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-        return seed;
-    }
-};
-
-struct VectorEqual {
-    bool operator()(const std::pair<std::vector<double>, double>& a, const std::pair<std::vector<double>, double>& b) const {
-        return a.second == b.second && a.first == b.first;
-    }
-};
-
-
-class KDTree {
+#include <string>
+#include <stdexcept>
+
+// Every stored point is addressed by its integer id: a table indexed by id
+// points at its node, and the per-point state (cluster, visited, neighbor
+// count and so core flag) sits in the id-indexed arrays of NeighborIndex, so
+// none of it needs a walk down the tree. Exact duplicate points are separate
+// points with their own ids. The calls that take a vector instead of an id
+// resolve it with one root-to-leaf walk (all copies of a point lie on the
+// same path, ties go right) and act on the lowest id holding those
+// coordinates; getIndices lists every copy.
+//
+// The metric is a policy from DistanceMetric.h and is compiled into the
+// search. Points are stored as Metric::prepare leaves them (unit vectors for
+// cosine) with their norm kept per id from insert time, and radius is in the
+// metric's units. KDTree is the euclidean tree.
+template <typename Metric = EuclideanMetric>
+class BasicKDTree : public NeighborIndex {
 public:
     struct Node {
         std::vector<double> point;
         std::shared_ptr<Node> left;
         std::shared_ptr<Node> right;
-        int clusterId;
-        int tick;
         int index;
-        bool visited_node;
+        int axis;
+        int subtreeSize;
 
-        Node(const std::vector<double>& pt, int idx) : point(pt), left(nullptr), right(nullptr), clusterId(-1), tick(0), visited_node(false), index(idx) {}
+        Node(const std::vector<double>& pt, int idx) : point(pt), left(nullptr), right(nullptr), index(idx), axis(0), subtreeSize(1) {}
     };
 
-    std::unordered_map<std::pair<std::vector<double>, double>, std::vector<std::vector<double>>, VectorHash, VectorEqual> radiusSearchCache;
-
+    // Shape of the tree; balance is height over the height of a perfectly balanced tree
+    struct TreeStats {
+        int size;
+        int height;
+        double averageDepth;
+        double balance;
+        int rebuilds;
+    };
 
     using NodePtr = std::shared_ptr<Node>;
 
-    KDTree(int dimensions) : dimensions(dimensions), root(nullptr) {}
+    BasicKDTree(int dimensions) : dimensions(dimensions), root(nullptr) {}
+
+    // Weight-balance factor: a subtree is rebuilt once one child holds more than alpha of its nodes
+    static constexpr double alpha = 0.7;
 
     std::vector<NodePtr> nodes;
 
-    void insert(const std::vector<double>& point, int index) {
+    void insert(const std::vector<double>& point, int index) override {
         NodePtr newNode = std::make_shared<Node>(point, index);
         nodes.push_back(newNode);
+        setNode(index, newNode.get(), Metric::prepare(newNode->point));
+        registerId(index);
+        scapegoatPending = false;
         root = insertRec(root, newNode, 0);
+        maxSize = std::max(maxSize, size());
+        pointInserted(index);
+    }
+
+    //Bulk load: add all points, then rebuild the whole tree with median splits on the highest-spread dimension
+    void build(const std::vector<std::vector<double>>& points, int startIndex = 0) override {
+        std::vector<NodePtr> items;
+        items.reserve(size() + points.size());
+        collectRec(root, items);
+        nodes.reserve(nodes.size() + points.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            NodePtr newNode = std::make_shared<Node>(points[i], startIndex + static_cast<int>(i));
+            nodes.push_back(newNode);
+            setNode(newNode->index, newNode.get(), Metric::prepare(newNode->point));
+            registerId(newNode->index);
+            items.push_back(newNode);
+        }
+        root = buildRec(items, 0, items.size());
+        maxSize = size();
+        ++rebuilds;
+        pointsInserted(startIndex, static_cast<int>(points.size()));
     }
 
     void remove(const std::vector<double>& point) {
-        root = removeRec(root, point, 0);
+        int id = getIndex(point);
+        if (id >= 0) {
+            removeById(id);
+        }
     }
 
+    void removeById(int id) override {
+        const Node* node = nodeById(id);
+        if (!node) return;
+        pointRemoving(id);
+        std::vector<double> point = node->point;
+        idToNode[id] = nullptr;
+        root = removeRec(root, point, id, 0);
+        // Deletions shrink the tree below the weight bound: rebuild it whole
+        if (root && size() < alpha * maxSize) {
+            root = rebuildSubtree(root);
+            maxSize = size();
+            //Drop the removed nodes from the node list along with the rebuild
+            nodes.clear();
+            collectRec(root, nodes);
+        }
+        if (!root) nodes.clear();
+    }
+
+    //Stored coordinates of the points within radius of target
     std::vector<std::vector<double>> radiusSearch(const std::vector<double>& target, double radius) {
+        std::vector<int> ids;
+        radiusSearchIds(target, radius, ids);
         std::vector<std::vector<double>> results;
-        radiusSearchRec(root, target, radius, 0, results);
+        results.reserve(ids.size());
+        for (int id : ids) results.push_back(nodeById(id)->point);
         return results;
     }
  
-    std::vector<std::vector<double>> radiusSearchUsingCache(const std::vector<double>& target, double radius) {
-        auto cacheKey = std::make_pair(target, radius);
 
-        // Check if the result is already in the cache
-        auto it = radiusSearchCache.find(cacheKey);
-        if (it != radiusSearchCache.end()) {
-            return it->second; // Return the cached result
+    //Collect the ids (and optionally squared distances) of all points within radius of target
+    void radiusSearchIds(const std::vector<double>& target, double radius, std::vector<int>& ids, std::vector<double>* sqDistances = nullptr) const override {
+        METRIC_SCOPE(RadiusQuery);
+        METRIC_ADD(RadiusQueries, 1);
+        if constexpr (Metric::rescales) {
+            //Rescaled copy of the query, kept per thread so queries do not allocate
+            thread_local std::vector<double> query;
+            query.assign(target.begin(), target.end());
+            double norm = Metric::prepare(query);
+            search(query, norm, radius, ids, sqDistances);
+        } else {
+            double norm = Metric::needsNorms ? std::sqrt(Distance::dot(target.data(), target.data(), target.size())) : 0.0;
+            search(target, norm, radius, ids, sqDistances);
         }
+    }
 
-        // Perform the search if not cached
-        std::vector<std::vector<double>> results;
-        radiusSearchRec(root, target, radius, 0, results);
-
-        // Store the result in the cache
-        radiusSearchCache[cacheKey] = results;
+    //Nearest accepted point, searched near side first with the cover shrinking to the best distance found
+    int nearestWithin(const std::vector<double>& target, double radius, const std::function<bool(int)>& accept, double* sqDistance = nullptr) const override {
+        METRIC_SCOPE(RadiusQuery);
+        METRIC_ADD(RadiusQueries, 1);
+        Nearest nearest{-1, Metric::threshold(radius), 0.0, 0.0};
+        const std::vector<double>* query = &target;
+        if constexpr (Metric::rescales) {
+            thread_local std::vector<double> scaled;
+            scaled.assign(target.begin(), target.end());
+            nearest.queryNorm = Metric::prepare(scaled);
+            query = &scaled;
+        } else if constexpr (Metric::needsNorms) {
+            nearest.queryNorm = std::sqrt(Distance::dot(target.data(), target.data(), target.size()));
+        }
+        nearest.cover = Metric::coverRadius(radius, nearest.queryNorm, maxNorm);
+        nearestRec(root.get(), *query, accept, nearest);
+        if (nearest.id >= 0 && sqDistance) *sqDistance = Metric::reported(nearest.key);
+        return nearest.id;
+    }
 
-        return results;
+    //Radius search around a stored point, addressed by id
+    void radiusSearchById(int id, double radius, std::vector<int>& ids, std::vector<double>* sqDistances = nullptr) const override {
+        METRIC_SCOPE(RadiusQuery);
+        METRIC_ADD(RadiusQueries, 1);
+        const Node* node = nodeById(id);
+        if (node) {
+            search(node->point, norms[id], radius, ids, sqDistances);
+        } else {
+            ids.clear();
+            if (sqDistances) sqDistances->clear();
+        }
     }
 
     // Assign a cluster ID to a specific point
     void assignClusterID(const std::vector<double>& point, int clusterID) {
-        NodePtr node = findNode(root, point, 0);
-        if (node) {
-            node->clusterId = clusterID;
+        int id = getIndex(point);
+        if (id >= 0) {
+            assignClusterIdById(id, clusterID);
         }
     }
 
     // Get the cluster ID for a specific point
     int getClusterId(const std::vector<double>& point) const {
-        NodePtr node = findNode(root, point, 0);
-        if(node) return node->clusterId;
+        int id = getIndex(point);
+        if (id >= 0) return getClusterIdById(id);
         else return -1;
     }
 
     // Update the cluster ID for a specific point
     void updateClusterId(const std::vector<double>& point, int newClusterId) {
-        NodePtr node = findNode(root, point, 0);
-        if (node) {
-            node->clusterId = newClusterId;
+        int id = getIndex(point);
+        if (id >= 0) {
+            assignClusterIdById(id, newClusterId);
         }
         else {
             std::cout << "Point not found in the tree." << std::endl;
         }
     }
     //Get the size of the tree
-    int size() const {
-        return sizeRec(root);
+    int size() const override {
+        return root ? root->subtreeSize : 0;
+    }
+
+    //Height, average depth and balance of the tree, plus the number of rebuilds so far
+    TreeStats stats() const {
+        TreeStats result{size(), 0, 0.0, 0.0, rebuilds};
+        long long depthSum = 0;
+        statsRec(root, 1, result.height, depthSum);
+        if (result.size > 0) {
+            result.averageDepth = static_cast<double>(depthSum) / result.size;
+            result.balance = result.height / std::log2(result.size + 1.0);
+        }
+        return result;
+    }
+
+    //Approximate bytes held by the nodes: one make_shared block and one coordinate buffer per point
+    size_t memoryUsage() const {
+        size_t bytes = nodes.capacity() * sizeof(NodePtr) + idToNode.capacity() * (sizeof(Node*) + sizeof(double));
+        for (const auto& node : nodes) {
+            bytes += sizeof(Node) + 2 * sizeof(long) + node->point.capacity() * sizeof(double);
+        }
+        return bytes;
     }
 
     //Set the visited node
     void setVisitedNode(const std::vector<double>& point, bool visited_node) {
-        NodePtr node = findNode(root, point, 0);
-        if (node) {
-            node->visited_node = visited_node;
+        int id = getIndex(point);
+        if (id >= 0) {
+            setVisitedById(id, visited_node);
         }
     }
 
     //Check if the node is visited
     bool isVisitedNode(const std::vector<double>& point) const {
-        NodePtr node = findNode(root, point, 0);
-        if (node) {
-            return node->visited_node;
+        int id = getIndex(point);
+        if (id >= 0) {
+            return isVisitedById(id);
         }
         return false;
     }
 
-    //Set all nodes to unvisited
-    void setAllNodesToUnvisited() {
-        setAllNodesToUnvisitedRec(root);
+    //Get the index of a point; the lowest id if it is stored more than once
+    int getIndex(const std::vector<double>& point) const {
+        std::vector<int> ids;
+        getIndices(point, ids);
+        return ids.empty() ? -1 : ids.front();
     }
 
-    //Set all nodes to unvisited recursively
-    void setAllNodesToUnvisitedRec(NodePtr node) {
-        if (node) {
-            node->visited_node = false;
-            setAllNodesToUnvisitedRec(node->left);
-            setAllNodesToUnvisitedRec(node->right);
+    //Ids of every stored copy of point, in ascending order
+    void getIndices(const std::vector<double>& point, std::vector<int>& ids) const {
+        if constexpr (Metric::rescales) {
+            std::vector<double> stored(point);
+            Metric::prepare(stored);
+            copiesOf(stored, ids);
+        } else {
+            copiesOf(point, ids);
         }
     }
 
-    //Merge clusterID1 to clusterID2
-    void mergeClusters(int clusterID1, int clusterID2) {
-        for (auto& node : nodes) {
-            if (node->clusterId == clusterID1) {
-                node->clusterId = clusterID2;
-            }
-        }
+    //Norm of a point as inserted, before Metric::prepare rescaled it
+    double normById(int id) const {
+        return nodeById(id) ? norms[id] : 0.0;
     }
 
-    //Get the index of a point
-    int getIndex(const std::vector<double>& point) const {
-        NodePtr node = findNode(root, point, 0);
-        if (node) {
-            return node->index;
-        }
-        return -1;
+    //Stored coordinates of a point (as Metric::prepare left them), resolved without walking the tree
+    const std::vector<double>& getPointById(int id) const {
+        const Node* node = nodeById(id);
+        if (!node) throw std::out_of_range("KDTree: no point with id " + std::to_string(id));
+        return node->point;
+    }
+
+    std::vector<double> getPoint(int id) const override {
+        return getPointById(id);
     }
 
 private:
     int dimensions;
     NodePtr root;
+    //Node of each id, nullptr for ids not stored; nodes are owned by the tree and nodes
+    std::vector<Node*> idToNode;
+    //Norm of each id as inserted, and the largest one so far (never lowered, so always a bound)
+    std::vector<double> norms;
+    double maxNorm = 0.0;
+
+    const Node* nodeById(int id) const {
+        return id >= 0 && id < static_cast<int>(idToNode.size()) ? idToNode[id] : nullptr;
+    }
+
+    void setNode(int id, Node* node, double norm) {
+        if (id >= static_cast<int>(idToNode.size())) {
+            idToNode.resize(id + 1, nullptr);
+            norms.resize(id + 1, 0.0);
+        }
+        idToNode[id] = node;
+        norms[id] = norm;
+        maxNorm = std::max(maxNorm, norm);
+    }
+
+    //Ids of the nodes holding exactly point (in stored coordinates); all lie on one root-to-leaf path
+    void copiesOf(const std::vector<double>& point, std::vector<int>& ids) const {
+        ids.clear();
+        for (const Node* node = root.get(); node; node = point[node->axis] < node->point[node->axis] ? node->left.get() : node->right.get()) {
+            if (node->point == point) ids.push_back(node->index);
+        }
+        std::sort(ids.begin(), ids.end());
+    }
 
-    int sizeRec(NodePtr node) const {
-        if (!node) return 0;
-        return 1 + sizeRec(node->left) + sizeRec(node->right);
+    //query is prepared; the tree is searched with the metric's euclidean cover radius
+    void search(const std::vector<double>& query, double queryNorm, double radius, std::vector<int>& ids, std::vector<double>* sqDistances) const {
+        ids.clear();
+        if (sqDistances) sqDistances->clear();
+        double cover = Metric::coverRadius(radius, queryNorm, maxNorm);
+        if (cover < 0.0) return;
+        radiusSearchIdsRec(root, query, cover, Metric::threshold(radius), 0, ids, sqDistances);
+    }
+
+    int maxSize = 0;
+    int rebuilds = 0;
+    bool scapegoatPending = false;
+
+    static int subtreeSize(const NodePtr& node) {
+        return node ? node->subtreeSize : 0;
+    }
+
+    void statsRec(const NodePtr& node, int depth, int& height, long long& depthSum) const {
+        if (!node) return;
+        height = std::max(height, depth);
+        depthSum += depth;
+        statsRec(node->left, depth + 1, height, depthSum);
+        statsRec(node->right, depth + 1, height, depthSum);
+    }
+
+    // Deepest a node may sit in a tree of n nodes before its path must hold a scapegoat
+    static int depthLimit(int n) {
+        return static_cast<int>(std::log(static_cast<double>(n)) / std::log(1.0 / alpha)) + 1;
     }
 
     NodePtr insertRec(NodePtr node, NodePtr newNode, int depth) {
-        if (!node) return newNode;
+        if (!node) {
+            newNode->axis = depth % dimensions;
+            scapegoatPending = depth > depthLimit(std::max(1, size()));
+            return newNode;
+        }
 
-        int axis = depth % dimensions;
+        node->subtreeSize++;
+        int axis = node->axis;
+        NodePtr child;
         if (newNode->point[axis] < node->point[axis])
-            node->left = insertRec(node->left, newNode, depth + 1);
+            child = node->left = insertRec(node->left, newNode, depth + 1);
         else
-            node->right = insertRec(node->right, newNode, depth + 1);
+            child = node->right = insertRec(node->right, newNode, depth + 1);
+
+        // The insert went too deep: rebuild the lowest ancestor whose child outweighs it
+        if (scapegoatPending && child->subtreeSize > alpha * node->subtreeSize) {
+            scapegoatPending = false;
+            return rebuildSubtree(node);
+        }
+        return node;
+    }
+
+    void collectRec(const NodePtr& node, std::vector<NodePtr>& items) const {
+        if (!node) return;
+        collectRec(node->left, items);
+        items.push_back(node);
+        collectRec(node->right, items);
+    }
+
+    NodePtr rebuildSubtree(const NodePtr& node) {
+        std::vector<NodePtr> items;
+        items.reserve(node->subtreeSize);
+        collectRec(node, items);
+        ++rebuilds;
+        return buildRec(items, 0, items.size());
+    }
 
+    // Median split on the dimension with the largest spread (estimated on a sample of the range)
+    NodePtr buildRec(std::vector<NodePtr>& items, size_t begin, size_t end) {
+        if (begin >= end) return nullptr;
+
+        size_t count = end - begin;
+        size_t step = std::max<size_t>(1, count / 256);
+        int axis = 0;
+        double bestSpread = -1.0;
+        for (int d = 0; d < dimensions; ++d) {
+            double lo = std::numeric_limits<double>::infinity();
+            double hi = -lo;
+            for (size_t i = begin; i < end; i += step) {
+                double v = items[i]->point[d];
+                lo = std::min(lo, v);
+                hi = std::max(hi, v);
+            }
+            if (hi - lo > bestSpread) {
+                bestSpread = hi - lo;
+                axis = d;
+            }
+        }
+
+        auto less = [axis](const NodePtr& a, const NodePtr& b) { return a->point[axis] < b->point[axis]; };
+        size_t mid = begin + count / 2;
+        std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end, less);
+        // Keep ties on the right so insert and getIndex descend the same way
+        double split = items[mid]->point[axis];
+        auto firstEqual = std::partition(items.begin() + begin, items.begin() + mid,
+                                         [axis, split](const NodePtr& n) { return n->point[axis] < split; });
+        std::iter_swap(firstEqual, items.begin() + mid);
+        mid = firstEqual - items.begin();
+
+        NodePtr node = items[mid];
+        node->axis = axis;
+        node->left = buildRec(items, begin, mid);
+        node->right = buildRec(items, mid + 1, end);
+        node->subtreeSize = 1 + subtreeSize(node->left) + subtreeSize(node->right);
         return node;
     }
 
-    NodePtr removeRec(NodePtr node, const std::vector<double>& point, int depth) {
+    // Remove the node holding id; point is its coordinates and steers the descent
+    NodePtr removeRec(NodePtr node, const std::vector<double>& point, int id, int depth) {
         if (!node) return nullptr;
 
-        int axis = depth % dimensions;
-        if (node->point == point) {
+        int axis = node->axis;
+        if (node->index == id) {
             if (!node->left)
                 return node->right;
             else if (!node->right)
                 return node->left;
 
-            NodePtr minNode = findMin(node->right, axis, depth + 1);
+            NodePtr minNode = findMin(node->right, axis);
             node->point = minNode->point;
-            node->right = removeRec(node->right, minNode->point, depth + 1);
+            node->index = minNode->index;
+            idToNode[node->index] = node.get(); // norms are kept by id and stay put
+            node->right = removeRec(node->right, minNode->point, minNode->index, depth + 1);
         } else if (point[axis] < node->point[axis]) {
-            node->left = removeRec(node->left, point, depth + 1);
+            node->left = removeRec(node->left, point, id, depth + 1);
         } else {
-            node->right = removeRec(node->right, point, depth + 1);
+            node->right = removeRec(node->right, point, id, depth + 1);
         }
+        node->subtreeSize = 1 + subtreeSize(node->left) + subtreeSize(node->right);
         return node;
     }
 
-    NodePtr findMin(NodePtr node, int axis, int depth) {
+    NodePtr findMin(NodePtr node, int axis) {
         if (!node) return nullptr;
 
-        int currentAxis = depth % dimensions;
-        if (currentAxis == axis) {
+        if (node->axis == axis) {
             if (!node->left) return node;
-            return findMin(node->left, axis, depth + 1);
+            return findMin(node->left, axis);
         }
-        return minNode(node, findMin(node->left, axis, depth + 1), findMin(node->right, axis, depth + 1), axis);
+        return minNode(node, findMin(node->left, axis), findMin(node->right, axis), axis);
     }
 
     NodePtr minNode(NodePtr a, NodePtr b, NodePtr c, int axis) {
@@ -224,40 +459,60 @@ private:
         return res;
     }
 
-    void radiusSearchRec(NodePtr node, const std::vector<double>& target, double radius, int depth, std::vector<std::vector<double>>& results) const {
-        if (!node) return;
+    struct Nearest {
+        int id;
+        double key;    // best key so far; the metric's threshold until something is accepted
+        double cover;  // euclidean cover radius of key
+        double queryNorm;
+    };
 
-        double dist = distance(node->point, target);
-        if (dist <= radius) {
-            results.push_back(node->point);
+    void nearestRec(const Node* node, const std::vector<double>& target, const std::function<bool(int)>& accept, Nearest& nearest) const {
+        if (!node || nearest.cover < 0.0) return;
+
+        METRIC_ADD(NodesVisited, 1);
+        METRIC_ADD(DistanceEvaluations, 1);
+        double key = Metric::key(node->point.data(), target.data(), dimensions, nearest.key);
+        bool better = nearest.id < 0 ? key <= nearest.key : key < nearest.key || (key == nearest.key && node->index < nearest.id);
+        if (better && accept(node->index)) {
+            nearest.id = node->index;
+            nearest.key = key;
+            //Clamped: a key that rounds below zero would otherwise end the search before equally near lower ids
+            nearest.cover = Metric::coverRadius(Metric::radiusOf(std::max(key, 0.0)), nearest.queryNorm, maxNorm);
         }
 
-        int axis = depth % dimensions;
-        if (target[axis] - radius <= node->point[axis])
-            radiusSearchRec(node->left, target, radius, depth + 1, results);
-        if (target[axis] + radius >= node->point[axis])
-            radiusSearchRec(node->right, target, radius, depth + 1, results);
+        int axis = node->axis;
+        bool leftFirst = target[axis] < node->point[axis];
+        const Node* first = leftFirst ? node->left.get() : node->right.get();
+        const Node* second = leftFirst ? node->right.get() : node->left.get();
+        nearestRec(first, target, accept, nearest);
+        //The cover may have shrunk below the distance to the splitting plane
+        if (std::fabs(target[axis] - node->point[axis]) <= nearest.cover) nearestRec(second, target, accept, nearest);
     }
 
-    NodePtr findNode(NodePtr node, const std::vector<double>& point, int depth) const {
-        if (!node) return nullptr;
+    //radius is the euclidean cover radius that prunes; key <= threshold is the metric's own test
+    void radiusSearchIdsRec(const NodePtr& node, const std::vector<double>& target, double radius, double threshold, int depth, std::vector<int>& ids, std::vector<double>* sqDistances) const {
+        if (!node) return;
 
-        if (node->point == point) return node;
+        METRIC_ADD(NodesVisited, 1);
+        METRIC_ADD(DistanceEvaluations, 1);
+        double key = Metric::key(node->point.data(), target.data(), dimensions, threshold);
+        if (key <= threshold) {
+            ids.push_back(node->index);
+            if (sqDistances) sqDistances->push_back(Metric::reported(key));
+        }
 
-        int axis = depth % dimensions;
-        if (point[axis] < node->point[axis])
-            return findNode(node->left, point, depth + 1);
-        else
-            return findNode(node->right, point, depth + 1);
+        int axis = node->axis;
+        if (target[axis] - radius <= node->point[axis])
+            radiusSearchIdsRec(node->left, target, radius, threshold, depth + 1, ids, sqDistances);
+        if (target[axis] + radius >= node->point[axis])
+            radiusSearchIdsRec(node->right, target, radius, threshold, depth + 1, ids, sqDistances);
     }
 
-    double distance(const std::vector<double>& a, const std::vector<double>& b) const {
-        double dist = 0.0;
-        for (size_t i = 0; i < a.size(); ++i) {
-            dist += (a[i] - b[i]) * (a[i] - b[i]);
-        }
-        return std::sqrt(dist);
-    }
 };
 
+using KDTree = BasicKDTree<EuclideanMetric>;
+using SquaredEuclideanKDTree = BasicKDTree<SquaredEuclideanMetric>;
+using CosineKDTree = BasicKDTree<CosineMetric>;
+using InnerProductKDTree = BasicKDTree<InnerProductMetric>;
+
 #endif
@@ -0,0 +1,165 @@
+// LabelSnapshots.h
+#ifndef LABELSNAPSHOTS_H
+#define LABELSNAPSHOTS_H
+
+#include "NeighborIndex.h"
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
+#include <string>
+
+// Published cluster labels for readers running alongside ingestion. The one
+// writer (the thread running INCDBSCAN) copies the labels into a new version
+// when a batch completes and swaps it in with a single atomic exchange;
+// readers pin the current version and read it with no lock while the next
+// batch inserts, relabels and merges in the index. Old versions are freed by
+// epoch: a reader announces the global epoch in its slot before loading the
+// version pointer, each exchange bumps the epoch, and a version swapped out
+// at epoch e is reclaimed once no slot holds an epoch below e. Reclaimed
+// versions go back to a pool, so publishing reuses their buffers. A read is
+// one store and one load, whatever the batch size.
+class LabelSnapshots {
+public:
+    // One published labeling: labels[id] for every stored id, -1 for noise
+    struct Version {
+        uint64_t sequence = 0; // 1 for the first publish, 0 before any
+        std::vector<int> labels;
+    };
+
+    // A pinned version. Reads stay consistent until the view is destroyed.
+    class View {
+    public:
+        View(View&& other) noexcept : version(other.version), slot(other.slot) { other.slot = nullptr; }
+        View(const View&) = delete;
+        View& operator=(const View&) = delete;
+        ~View() {
+            if (slot) slot->store(0, std::memory_order_release);
+        }
+
+        int label(int id) const {
+            return id >= 0 && id < static_cast<int>(version->labels.size()) ? version->labels[id] : -1;
+        }
+        int size() const { return static_cast<int>(version->labels.size()); }
+        uint64_t sequence() const { return version->sequence; }
+        const std::vector<int>& labels() const { return version->labels; }
+
+    private:
+        friend class LabelSnapshots;
+        View(const Version* version, std::atomic<uint64_t>* slot) : version(version), slot(slot) {}
+        const Version* version;
+        std::atomic<uint64_t>* slot;
+    };
+
+    // A reader thread's slot. Holds one view at a time.
+    class Reader {
+    public:
+        explicit Reader(LabelSnapshots& snapshots) : snapshots(snapshots), slot(snapshots.claimSlot()) {}
+        ~Reader() { snapshots.slots[slot].claimed.store(false, std::memory_order_release); }
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        View pin() { return snapshots.pin(slot); }
+
+    private:
+        LabelSnapshots& snapshots;
+        int slot;
+    };
+
+    explicit LabelSnapshots(int maxReaders = 64) : slots(maxReaders) {
+        current.store(new Version(), std::memory_order_release);
+    }
+
+    ~LabelSnapshots() {
+        delete current.load();
+        for (auto& entry : retired) delete entry.version;
+        for (Version* version : pool) delete version;
+    }
+
+    LabelSnapshots(const LabelSnapshots&) = delete;
+    LabelSnapshots& operator=(const LabelSnapshots&) = delete;
+
+    //Writer only: make the index's current labels the version readers see
+    void publish(const NeighborIndex& index) {
+        Version* version = take();
+        index.clusterLabels(version->labels);
+        install(version);
+    }
+
+    void publish(const std::vector<int>& labels) {
+        Version* version = take();
+        version->labels.assign(labels.begin(), labels.end());
+        install(version);
+    }
+
+    //Number of versions published so far
+    uint64_t published() const { return publishes; }
+
+    //Versions swapped out but still pinned by some reader
+    size_t retiredCount() const { return retired.size(); }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch{0}; // 0: not reading
+        std::atomic<bool> claimed{false};
+    };
+
+    struct Retired {
+        Version* version;
+        uint64_t epoch;
+    };
+
+    std::vector<Slot> slots;
+    std::atomic<Version*> current{nullptr};
+    std::atomic<uint64_t> globalEpoch{1};
+    //Writer-side state
+    std::vector<Retired> retired;
+    std::vector<Version*> pool;
+    uint64_t publishes = 0;
+
+    int claimSlot() {
+        for (size_t s = 0; s < slots.size(); ++s) {
+            bool expected = false;
+            if (slots[s].claimed.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) return static_cast<int>(s);
+        }
+        throw std::runtime_error("LabelSnapshots: all " + std::to_string(slots.size()) + " reader slots are taken");
+    }
+
+    View pin(int slot) {
+        std::atomic<uint64_t>& epoch = slots[slot].epoch;
+        //Announce before loading: a version loaded here cannot be reclaimed until the slot is cleared
+        epoch.store(globalEpoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        return View(current.load(std::memory_order_seq_cst), &epoch);
+    }
+
+    Version* take() {
+        if (pool.empty()) return new Version();
+        Version* version = pool.back();
+        pool.pop_back();
+        return version;
+    }
+
+    void install(Version* version) {
+        version->sequence = ++publishes;
+        Version* old = current.exchange(version, std::memory_order_seq_cst);
+        retired.push_back({old, globalEpoch.fetch_add(1, std::memory_order_seq_cst) + 1});
+        reclaim();
+    }
+
+    //Pool every retired version no reader can still hold
+    void reclaim() {
+        uint64_t oldest = std::numeric_limits<uint64_t>::max();
+        for (const Slot& slot : slots) {
+            uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+            if (epoch != 0) oldest = std::min(oldest, epoch);
+        }
+        auto reclaimable = std::partition(retired.begin(), retired.end(), [&](const Retired& entry) { return entry.epoch > oldest; });
+        for (auto it = reclaimable; it != retired.end(); ++it) pool.push_back(it->version);
+        retired.erase(reclaimable, retired.end());
+    }
+};
+
+#endif
@@ -0,0 +1,158 @@
+// LabelWriter.h
+#ifndef LABELWRITER_H
+#define LABELWRITER_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+#include <stdexcept>
+
+// Buffered text export of cluster assignments: one "name,cluster" line per
+// point, the format main.cpp writes. Rows are formatted into a block buffer
+// and go out in one fwrite per block instead of one open, write and close per
+// point. The file is flushed and closed by close() or the destructor.
+class CsvLabelWriter {
+public:
+    explicit CsvLabelWriter(const std::string& path, bool append = false, size_t bufferBytes = size_t(1) << 20)
+        : path(path), capacity(std::max<size_t>(bufferBytes, 64)) {
+        file = std::fopen(path.c_str(), append ? "ab" : "wb");
+        if (!file) throw std::runtime_error("CsvLabelWriter: cannot open " + path);
+        buffer.reserve(capacity);
+    }
+
+    //Errors surface only through close(); a writer that is just dropped flushes quietly
+    ~CsvLabelWriter() {
+        if (file) {
+            std::fwrite(buffer.data(), 1, buffer.size(), file);
+            std::fclose(file);
+        }
+    }
+
+    CsvLabelWriter(const CsvLabelWriter&) = delete;
+    CsvLabelWriter& operator=(const CsvLabelWriter&) = delete;
+
+    void write(const std::string& name, int cluster) {
+        if (buffer.size() + name.size() + 16 > capacity) flush();
+        buffer.append(name);
+        char digits[16];
+        digits[0] = ',';
+        char* end = std::to_chars(digits + 1, digits + sizeof(digits) - 1, cluster).ptr;
+        *end++ = '\n';
+        buffer.append(digits, end);
+    }
+
+    //Rows names[k], clusters[k] for every k < names.size()
+    void write(const std::vector<std::string>& names, const int* clusters) {
+        for (size_t k = 0; k < names.size(); ++k) write(names[k], clusters[k]);
+    }
+
+    void flush() {
+        if (!buffer.empty() && std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+            throw std::runtime_error("CsvLabelWriter: cannot write " + path);
+        }
+        buffer.clear();
+    }
+
+    void close() {
+        if (!file) return;
+        flush();
+        bool closed = std::fclose(file) == 0;
+        file = nullptr;
+        if (!closed) throw std::runtime_error("CsvLabelWriter: cannot write " + path);
+    }
+
+private:
+    std::string path;
+    size_t capacity;
+    std::string buffer;
+    std::FILE* file = nullptr;
+};
+
+// Binary export of cluster assignments with the dataset labels interned: a
+// 32-byte header (magic "INCDBLBL", version, point count, name count), then
+// the int32 cluster of every point, the int32 name index of every point, and
+// the name table as length-prefixed strings. Native byte order.
+class BinaryLabelWriter {
+public:
+    static constexpr uint32_t formatVersion = 1;
+
+    //Point k has cluster clusters[k] and name names[nameIds[k]]
+    static void save(const std::string& path, const int* clusters, const int* nameIds, size_t count, const std::vector<std::string>& names) {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) throw std::runtime_error("BinaryLabelWriter: cannot create " + path);
+        Header header{};
+        std::memcpy(header.magic, magic, sizeof(header.magic));
+        header.version = formatVersion;
+        header.count = count;
+        header.nameCount = names.size();
+        bool written = std::fwrite(&header, sizeof(Header), 1, file) == 1 &&
+                       std::fwrite(clusters, sizeof(int32_t), count, file) == count &&
+                       std::fwrite(nameIds, sizeof(int32_t), count, file) == count;
+        for (size_t n = 0; written && n < names.size(); ++n) {
+            uint32_t length = static_cast<uint32_t>(names[n].size());
+            written = std::fwrite(&length, sizeof(length), 1, file) == 1 && std::fwrite(names[n].data(), 1, length, file) == length;
+        }
+        written = std::fclose(file) == 0 && written;
+        if (!written) throw std::runtime_error("BinaryLabelWriter: cannot write " + path);
+    }
+
+    //Point k has cluster clusters[k] and name names[k]; repeated names are stored once
+    static void save(const std::string& path, const std::vector<int>& clusters, const std::vector<std::string>& names) {
+        if (names.size() != clusters.size()) throw std::runtime_error("BinaryLabelWriter: " + std::to_string(names.size()) + " names for " +
+                                                                      std::to_string(clusters.size()) + " clusters");
+        std::unordered_map<std::string, int> interned;
+        std::vector<std::string> table;
+        std::vector<int> nameIds(names.size());
+        for (size_t k = 0; k < names.size(); ++k) {
+            auto it = interned.emplace(names[k], static_cast<int>(table.size())).first;
+            if (it->second == static_cast<int>(table.size())) table.push_back(names[k]);
+            nameIds[k] = it->second;
+        }
+        save(path, clusters.data(), nameIds.data(), clusters.size(), table);
+    }
+
+    //Read a file written by save()
+    static void load(const std::string& path, std::vector<int>& clusters, std::vector<int>& nameIds, std::vector<std::string>& names) {
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) throw std::runtime_error("BinaryLabelWriter: cannot open " + path);
+        Header header{};
+        bool read = std::fread(&header, sizeof(Header), 1, file) == 1 && std::memcmp(header.magic, magic, sizeof(header.magic)) == 0 &&
+                    header.version == formatVersion;
+        if (read) {
+            clusters.resize(header.count);
+            nameIds.resize(header.count);
+            names.assign(header.nameCount, std::string());
+            read = std::fread(clusters.data(), sizeof(int32_t), header.count, file) == header.count &&
+                   std::fread(nameIds.data(), sizeof(int32_t), header.count, file) == header.count;
+        }
+        for (size_t n = 0; read && n < names.size(); ++n) {
+            uint32_t length = 0;
+            read = std::fread(&length, sizeof(length), 1, file) == 1;
+            if (read) {
+                names[n].resize(length);
+                read = std::fread(names[n].data(), 1, length, file) == length;
+            }
+        }
+        std::fclose(file);
+        if (!read) throw std::runtime_error("BinaryLabelWriter: " + path + " is not a label file or is truncated");
+    }
+
+private:
+    static constexpr char magic[8] = {'I', 'N', 'C', 'D', 'B', 'L', 'B', 'L'};
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t count;
+        uint64_t nameCount;
+    };
+    static_assert(sizeof(Header) == 32, "label file header must stay 32 bytes");
+};
+
+#endif
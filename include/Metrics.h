@@ -0,0 +1,310 @@
+// Metrics.h
+#ifndef METRICS_H
+#define METRICS_H
+
+#ifndef INCDBSCAN_METRICS
+#define INCDBSCAN_METRICS 0
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Counters and latency histograms for the clustering code. They are compiled in
+// with -DINCDBSCAN_METRICS=1; otherwise the METRIC_* macros expand to nothing
+// and a build pays nothing for them. Each thread writes its own shard, so
+// recording takes no lock and shares no cache line, and snapshot() sums the
+// shards. Latencies go into power-of-two nanosecond buckets. While a trace is
+// running, every timed scope is also kept as a Chrome trace event, written by
+// stopTrace() for chrome://tracing or Perfetto. Summary lines that DBSCAN and
+// INCDBSCAN print per call can be switched off with setLogging(false).
+class Metrics {
+public:
+    enum Counter {
+        RadiusQueries,
+        NodesVisited,
+        DistanceEvaluations,
+        CacheHits,
+        CacheMisses,
+        InsertNoise,         // new point has fewer than minPts neighbors
+        InsertNewCluster,    // CASE A: no labeled neighbor
+        InsertJoinCluster,   // CASE B: neighbors carry one label
+        InsertMergeClusters, // CASE C: neighbors carry several labels
+        ClusterMerges,
+        ClusterExpansions,
+        PointsRemoved,
+        ClusterSplits,
+        CounterCount
+    };
+
+    enum Timer {
+        RadiusQuery,
+        DBSCANCluster,
+        ExpandCluster,
+        INCDBSCANBatch,
+        InsertPoint,
+        RemovePoints,
+        Predict,
+        TimerCount
+    };
+
+    //Bucket b holds latencies below 2^b nanoseconds; the last one takes everything longer
+    static constexpr int buckets = 40;
+
+    struct Histogram {
+        uint64_t count = 0;
+        uint64_t totalNanos = 0;
+        uint64_t maxNanos = 0;
+        std::array<uint64_t, buckets> counts{};
+
+        double meanSeconds() const { return count ? totalNanos * 1e-9 / count : 0.0; }
+
+        //Upper edge of the bucket holding quantile q
+        double quantileSeconds(double q) const {
+            uint64_t rank = static_cast<uint64_t>(q * count);
+            uint64_t seen = 0;
+            for (int b = 0; b < buckets; ++b) {
+                seen += counts[b];
+                if (seen > rank) return std::min<double>(static_cast<double>(uint64_t(1) << b), static_cast<double>(maxNanos)) * 1e-9;
+            }
+            return maxNanos * 1e-9;
+        }
+    };
+
+    struct Report {
+        std::array<uint64_t, CounterCount> counters{};
+        std::array<Histogram, TimerCount> timers{};
+
+        uint64_t counter(Counter c) const { return counters[c]; }
+        const Histogram& timer(Timer t) const { return timers[t]; }
+
+        void print(std::ostream& out) const {
+            for (int c = 0; c < CounterCount; ++c) {
+                if (counters[c]) out << counterName(static_cast<Counter>(c)) << ": " << counters[c] << "\n";
+            }
+            for (int t = 0; t < TimerCount; ++t) {
+                const Histogram& h = timers[t];
+                if (!h.count) continue;
+                out << timerName(static_cast<Timer>(t)) << ": " << h.count << " calls, " << h.totalNanos * 1e-9 << " s total, mean "
+                    << h.meanSeconds() << " s, p50 " << h.quantileSeconds(0.5) << " s, p99 " << h.quantileSeconds(0.99) << " s, max "
+                    << h.maxNanos * 1e-9 << " s\n";
+            }
+        }
+
+        std::string toJson() const {
+            std::ostringstream out;
+            out << "{\"counters\": {";
+            for (int c = 0; c < CounterCount; ++c) out << (c ? ", " : "") << "\"" << counterName(static_cast<Counter>(c)) << "\": " << counters[c];
+            out << "}, \"timers\": {";
+            for (int t = 0; t < TimerCount; ++t) {
+                const Histogram& h = timers[t];
+                out << (t ? ", " : "") << "\"" << timerName(static_cast<Timer>(t)) << "\": {\"count\": " << h.count << ", \"total_s\": "
+                    << h.totalNanos * 1e-9 << ", \"p50_s\": " << h.quantileSeconds(0.5) << ", \"p99_s\": " << h.quantileSeconds(0.99)
+                    << ", \"max_s\": " << h.maxNanos * 1e-9 << "}";
+            }
+            out << "}}";
+            return out.str();
+        }
+    };
+
+    static const char* counterName(Counter c) {
+        static const char* names[CounterCount] = {"radius_queries", "nodes_visited", "distance_evaluations", "cache_hits", "cache_misses",
+                                                  "insert_noise", "insert_new_cluster", "insert_join_cluster", "insert_merge_clusters",
+                                                  "cluster_merges", "cluster_expansions", "points_removed", "cluster_splits"};
+        return names[c];
+    }
+
+    static const char* timerName(Timer t) {
+        static const char* names[TimerCount] = {"radius_query", "dbscan_cluster", "expand_cluster", "incdbscan_batch", "insert_point",
+                                                "remove_points", "predict"};
+        return names[t];
+    }
+
+    static void add(Counter c, uint64_t n = 1) {
+        bump(shard().counters[c], n);
+    }
+
+    static void record(Timer t, uint64_t nanos) {
+        Shard& s = shard();
+        bump(s.histograms[t][bucketOf(nanos)], 1);
+        bump(s.totals[t], nanos);
+        if (nanos > s.maxima[t].load(std::memory_order_relaxed)) s.maxima[t].store(nanos, std::memory_order_relaxed);
+    }
+
+    //Sum of every thread's counters and histograms so far
+    static Report snapshot() {
+        Report report;
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (const auto& s : r.shards) {
+            for (int c = 0; c < CounterCount; ++c) report.counters[c] += s->counters[c].load(std::memory_order_relaxed);
+            for (int t = 0; t < TimerCount; ++t) {
+                Histogram& h = report.timers[t];
+                for (int b = 0; b < buckets; ++b) {
+                    uint64_t n = s->histograms[t][b].load(std::memory_order_relaxed);
+                    h.counts[b] += n;
+                    h.count += n;
+                }
+                h.totalNanos += s->totals[t].load(std::memory_order_relaxed);
+                h.maxNanos = std::max(h.maxNanos, s->maxima[t].load(std::memory_order_relaxed));
+            }
+        }
+        return report;
+    }
+
+    //Zero everything; call while nothing is being recorded
+    static void reset() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (const auto& s : r.shards) s->clear();
+    }
+
+    //Start keeping a trace event for every timed scope
+    static void startTrace() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.events.clear();
+        r.traceStart = std::chrono::steady_clock::now();
+        r.tracing.store(true, std::memory_order_release);
+    }
+
+    //Stop tracing and write the events as Chrome trace JSON; false if the file cannot be written
+    static bool stopTrace(const std::string& path) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.tracing.store(false, std::memory_order_release);
+        std::ofstream out(path);
+        out << "{\"traceEvents\": [";
+        for (size_t e = 0; e < r.events.size(); ++e) {
+            const Event& event = r.events[e];
+            out << (e ? ",\n" : "\n") << "{\"name\": \"" << timerName(event.timer) << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.thread
+                << ", \"ts\": " << event.startNanos / 1000.0 << ", \"dur\": " << event.durationNanos / 1000.0 << "}";
+        }
+        out << "\n]}\n";
+        r.events.clear();
+        return static_cast<bool>(out);
+    }
+
+    //Per-call summary lines from DBSCAN and INCDBSCAN; on by default
+    static void setLogging(bool on) {
+        loggingFlag().store(on, std::memory_order_relaxed);
+    }
+
+    static bool logging() {
+        return loggingFlag().load(std::memory_order_relaxed);
+    }
+
+    //Records the lifetime of a scope under a timer
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Timer timer) : timer(timer), start(std::chrono::steady_clock::now()) {}
+
+        ~ScopedTimer() {
+            auto end = std::chrono::steady_clock::now();
+            uint64_t nanos = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+            record(timer, nanos);
+            Registry& r = registry();
+            if (r.tracing.load(std::memory_order_acquire)) {
+                std::lock_guard<std::mutex> lock(r.mutex);
+                if (start >= r.traceStart) {
+                    uint64_t offset = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(start - r.traceStart).count());
+                    r.events.push_back({timer, shard().index, offset, nanos});
+                }
+            }
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Timer timer;
+        std::chrono::steady_clock::time_point start;
+    };
+
+private:
+    //Written only by its own thread, read by snapshot()
+    struct Shard {
+        int index = 0;
+        std::array<std::atomic<uint64_t>, CounterCount> counters{};
+        std::array<std::array<std::atomic<uint64_t>, buckets>, TimerCount> histograms{};
+        std::array<std::atomic<uint64_t>, TimerCount> totals{};
+        std::array<std::atomic<uint64_t>, TimerCount> maxima{};
+
+        void clear() {
+            for (auto& c : counters) c.store(0, std::memory_order_relaxed);
+            for (auto& h : histograms) {
+                for (auto& b : h) b.store(0, std::memory_order_relaxed);
+            }
+            for (auto& t : totals) t.store(0, std::memory_order_relaxed);
+            for (auto& m : maxima) m.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    struct Event {
+        Timer timer;
+        int thread;
+        uint64_t startNanos;
+        uint64_t durationNanos;
+    };
+
+    //Shards outlive their threads so their counts stay in the totals
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Shard>> shards;
+        std::atomic<bool> tracing{false};
+        std::chrono::steady_clock::time_point traceStart;
+        std::vector<Event> events;
+    };
+
+    static Registry& registry() {
+        static Registry r;
+        return r;
+    }
+
+    static Shard& shard() {
+        thread_local Shard* s = [] {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.shards.push_back(std::make_unique<Shard>());
+            r.shards.back()->index = static_cast<int>(r.shards.size());
+            return r.shards.back().get();
+        }();
+        return *s;
+    }
+
+    static std::atomic<bool>& loggingFlag() {
+        static std::atomic<bool> on{true};
+        return on;
+    }
+
+    //Single writer, so a plain load and store instead of a locked add
+    static void bump(std::atomic<uint64_t>& value, uint64_t n) {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static int bucketOf(uint64_t nanos) {
+        int b = nanos ? 64 - __builtin_clzll(nanos) : 0;
+        return b < buckets ? b : buckets - 1;
+    }
+};
+
+#if INCDBSCAN_METRICS
+#define METRIC_CONCAT_INNER(a, b) a##b
+#define METRIC_CONCAT(a, b) METRIC_CONCAT_INNER(a, b)
+#define METRIC_ADD(counter, n) Metrics::add(Metrics::counter, (n))
+#define METRIC_SCOPE(timer) Metrics::ScopedTimer METRIC_CONCAT(metricScope, __LINE__)(Metrics::timer)
+#else
+#define METRIC_ADD(counter, n) do {} while (0)
+#define METRIC_SCOPE(timer) do {} while (0)
+#endif
+
+#endif
@@ -0,0 +1,378 @@
+// NeighborIndex.h
+#ifndef NEIGHBORINDEX_H
+#define NEIGHBORINDEX_H
+
+#include "DisjointSet.h"
+#include "NeighborhoodCache.h"
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <functional>
+
+// Interface DBSCAN and INCDBSCAN cluster against. A backend stores points under
+// caller-chosen integer ids and answers radius queries with ids; the per-point
+// cluster state (cluster id, visited flag, eps-neighbor count) and the
+// neighborhood cache are kept here, indexed by id, so they are shared by every
+// backend. Cluster ids go through a disjoint-set: merging
+// two clusters is a union, and reading a point's cluster resolves its stored
+// label to the representative of its set.
+class NeighborIndex {
+public:
+    virtual ~NeighborIndex() = default;
+
+    virtual void insert(const std::vector<double>& point, int index) = 0;
+
+    //Bulk load points under ids startIndex, startIndex + 1, ...
+    virtual void build(const std::vector<std::vector<double>>& points, int startIndex = 0) {
+        for (size_t i = 0; i < points.size(); ++i) {
+            insert(points[i], startIndex + static_cast<int>(i));
+        }
+    }
+
+    virtual void removeById(int id) = 0;
+
+    //Collect the ids (and optionally squared distances) of all points within radius of target
+    virtual void radiusSearchIds(const std::vector<double>& target, double radius, std::vector<int>& ids, std::vector<double>* sqDistances = nullptr) const = 0;
+
+    // Nearest point within radius of target that accept(id) takes: its id, or -1,
+    // with its squared distance in *sqDistance. Of equally near points the lowest
+    // id wins. accept is only asked about points nearer than the best so far; the
+    // default filters a full radius search, backends may prune as the best improves.
+    virtual int nearestWithin(const std::vector<double>& target, double radius, const std::function<bool(int)>& accept, double* sqDistance = nullptr) const {
+        thread_local std::vector<int> ids;
+        thread_local std::vector<double> sqDistances;
+        radiusSearchIds(target, radius, ids, &sqDistances);
+        int best = -1;
+        double bestSq = 0.0;
+        for (size_t k = 0; k < ids.size(); ++k) {
+            if (best >= 0 && (sqDistances[k] > bestSq || (sqDistances[k] == bestSq && ids[k] > best))) continue;
+            if (!accept(ids[k])) continue;
+            best = ids[k];
+            bestSq = sqDistances[k];
+        }
+        if (best >= 0 && sqDistance) *sqDistance = bestSq;
+        return best;
+    }
+
+    //Radius search around a stored point, addressed by id; empty once the point is removed
+    virtual void radiusSearchById(int id, double radius, std::vector<int>& ids, std::vector<double>* sqDistances = nullptr) const = 0;
+
+    //Radius search around a stored point that also marks, in inner[k], whether ids[k] lies
+    //within innerRadius; backends whose exact distances are costly may settle the marks cheaper
+    virtual void radiusSearchByIdSplit(int id, double radius, double innerRadius, std::vector<int>& ids, std::vector<char>& inner) const {
+        if (innerRadius >= radius) {
+            radiusSearchById(id, radius, ids);
+            inner.assign(ids.size(), 1);
+            return;
+        }
+        thread_local std::vector<double> sqDistances;
+        radiusSearchById(id, radius, ids, &sqDistances);
+        double innerSq = innerRadius * innerRadius;
+        inner.resize(ids.size());
+        for (size_t k = 0; k < ids.size(); ++k) inner[k] = sqDistances[k] <= innerSq;
+    }
+
+    virtual std::vector<double> getPoint(int id) const = 0;
+
+    virtual int size() const = 0;
+
+    //False for approximate backends, whose radius queries may miss neighbors
+    virtual bool isExact() const { return true; }
+
+    //True for backends that answer many queries at once faster than one by one
+    virtual bool batchQueries() const { return false; }
+
+    //Neighborhoods of the stored points queryIds as CSR: the neighbors of
+    //queryIds[q] are ids[offsets[q]..offsets[q+1])
+    virtual void radiusSearchBatch(const std::vector<int>& queryIds, double radius, std::vector<int>& offsets, std::vector<int>& ids) const {
+        offsets.assign(1, 0);
+        ids.clear();
+        std::vector<int> found;
+        for (int id : queryIds) {
+            radiusSearchById(id, radius, found);
+            ids.insert(ids.end(), found.begin(), found.end());
+            offsets.push_back(static_cast<int>(ids.size()));
+        }
+    }
+
+    //Neighborhood cache in front of radiusSearchById
+    void radiusSearchByIdUsingCache(int id, double radius, std::vector<int>& ids) {
+        if (const std::vector<int>* cached = neighborhoodCache.find(id, radius)) {
+            ids = *cached;
+            return;
+        }
+        radiusSearchById(id, radius, ids);
+        neighborhoodCache.put(id, radius, ids);
+    }
+
+    //Bytes the neighborhood cache may hold before it starts evicting
+    void setCacheBudget(size_t bytes) {
+        neighborhoodCache.setBudget(bytes);
+    }
+
+    NeighborhoodCache::Stats cacheStats() const {
+        return neighborhoodCache.stats();
+    }
+
+    //Fill the neighborhood cache for queryIds with one batch query
+    void prefetchNeighborhoods(const std::vector<int>& queryIds, double radius) {
+        std::vector<int> offsets;
+        std::vector<int> ids;
+        radiusSearchBatch(queryIds, radius, offsets, ids);
+        for (size_t q = 0; q < queryIds.size(); ++q) {
+            neighborhoodCache.put(queryIds[q], radius, std::vector<int>(ids.begin() + offsets[q], ids.begin() + offsets[q + 1]));
+        }
+    }
+
+    //Number of stored points within radius of id (itself included); looked up once, then kept
+    //current by every insert and remove. Counts are kept for one radius at a time.
+    int neighborCount(int id, double radius) {
+        if (!contains(id)) return 0;
+        trackNeighborCounts(radius);
+        if (neighborCounts[id] < 0) {
+            radiusSearchByIdUsingCache(id, radius, updateScratch.counting);
+            neighborCounts[id] = static_cast<int>(updateScratch.counting.size());
+        }
+        return neighborCounts[id];
+    }
+
+    bool isCore(int id, double radius, int minPts) {
+        return neighborCount(id, radius) >= minPts;
+    }
+
+    //The count neighborCount(id, radius) holds for id, or -1 if it is not known; never searches
+    int knownNeighborCount(int id, double radius) const {
+        return contains(id) && radius == countRadius ? neighborCounts[id] : -1;
+    }
+
+    //Record a count a caller already measured with its own search
+    void recordNeighborCount(int id, double radius, int count) {
+        if (!contains(id)) return;
+        trackNeighborCounts(radius);
+        neighborCounts[id] = count;
+    }
+
+    //Keep counts for radius from here on, so inserts and bulk loads record them; forgets counts kept for another radius
+    void trackNeighborCounts(double radius) {
+        if (radius != countRadius) {
+            std::fill(neighborCounts.begin(), neighborCounts.end(), -1);
+            countRadius = radius;
+        }
+    }
+
+    int getClusterIdById(int id) const {
+        return contains(id) ? clusterSets.root(clusterIds[id]) : -1;
+    }
+
+    void assignClusterIdById(int id, int clusterID) {
+        if (contains(id)) {
+            clusterIds[id] = clusterID;
+            clusterSets.ensure(clusterID);
+        }
+    }
+
+    bool isVisitedById(int id) const {
+        return contains(id) ? visitedFlags[id] != 0 : false;
+    }
+
+    void setVisitedById(int id, bool visited_node) {
+        if (contains(id)) {
+            visitedFlags[id] = visited_node;
+        }
+    }
+
+    //Set all points to unvisited
+    void setAllNodesToUnvisited() {
+        std::fill(visitedFlags.begin(), visitedFlags.end(), 0);
+    }
+
+    //Merge the clusters of clusterID1 and clusterID2; returns the id both now resolve to
+    int mergeClusters(int clusterID1, int clusterID2) {
+        if (clusterID1 < 0 || clusterID2 < 0) return std::max(clusterID1, clusterID2);
+        return clusterSets.unite(clusterID1, clusterID2);
+    }
+
+    //Resolve a cluster id to the id of the cluster it was merged into
+    int resolveClusterId(int clusterID) {
+        return clusterSets.find(clusterID);
+    }
+
+    //One past the largest id stored so far
+    int idBound() const {
+        return static_cast<int>(clusterIds.size());
+    }
+
+    //One past the largest cluster id handed out so far
+    int clusterIdBound() const {
+        return clusterSets.labels();
+    }
+
+    //Renumber the clusters in use to 0..k-1 (in order of their lowest point id) and return k
+    int compactClusterIds() {
+        std::vector<int> mapping(clusterSets.labels(), -1);
+        int next = 0;
+        for (int& clusterId : clusterIds) {
+            if (clusterId < 0) continue;
+            int rep = clusterSets.find(clusterId);
+            if (mapping[rep] < 0) mapping[rep] = next++;
+            clusterId = mapping[rep];
+        }
+        clusterSets.reset(next);
+        return next;
+    }
+
+    //Cluster ids of points first..last-1 (last -1: every id) resolved through the merges in one
+    //pass, labels[k] for id first + k; ids never stored read -1
+    void clusterLabels(std::vector<int>& labels, int first = 0, int last = -1) const {
+        int end = static_cast<int>(clusterIds.size());
+        if (last < 0) last = end;
+        first = std::max(first, 0);
+        labels.assign(std::max(last - first, 0), -1);
+        std::vector<int> roots(clusterSets.labels());
+        for (int label = 0; label < static_cast<int>(roots.size()); ++label) roots[label] = clusterSets.root(label);
+        for (int id = first; id < std::min(last, end); ++id) {
+            int clusterId = clusterIds[id];
+            labels[id - first] = clusterId >= 0 && clusterId < static_cast<int>(roots.size()) ? roots[clusterId] : clusterId;
+        }
+    }
+
+    //Per-point state as flat arrays indexed by id, cluster ids resolved through the merges
+    void exportPointState(std::vector<int>& clusters, std::vector<char>& visited, std::vector<int>& counts, double& radius) const {
+        clusters.resize(clusterIds.size());
+        for (size_t id = 0; id < clusterIds.size(); ++id) clusters[id] = clusterSets.root(clusterIds[id]);
+        visited = visitedFlags;
+        counts = neighborCounts;
+        radius = countRadius;
+    }
+
+    //Replace the per-point state with count entries from exportPointState; the cache starts empty
+    void importPointState(size_t count, const int* clusters, const char* visited, const int* counts, double radius) {
+        clusterIds.assign(clusters, clusters + count);
+        visitedFlags.assign(visited, visited + count);
+        neighborCounts.assign(counts, counts + count);
+        countRadius = radius;
+        int bound = 0;
+        for (int clusterId : clusterIds) bound = std::max(bound, clusterId + 1);
+        clusterSets.reset(bound);
+        neighborhoodCache.clear();
+    }
+
+protected:
+    //Make room for per-point state of a newly stored id
+    void registerId(int id) {
+        if (id >= static_cast<int>(clusterIds.size())) {
+            clusterIds.resize(id + 1, -1);
+            visitedFlags.resize(id + 1, 0);
+            neighborCounts.resize(id + 1, -1);
+        }
+        clusterIds[id] = -1;
+        visitedFlags[id] = 0;
+        neighborCounts[id] = -1;
+    }
+
+    //Backends call this once an inserted point is searchable
+    void pointInserted(int id) {
+        updateAround(id, 1);
+    }
+
+    //Backends call this once a bulk load has made ids first..first+count-1 searchable
+    //together: each is counted by its own query, the points stored before move by one
+    //per new neighbor
+    void pointsInserted(int first, int count) {
+        if (!batchQueries()) {
+            for (int id = first; id < first + count; ++id) {
+                updateAround(id, 1, first, first + count);
+            }
+            return;
+        }
+        //One batch query for the whole load; cached neighborhoods wider than the count
+        //radius are dropped rather than searched for
+        bool counting = countRadius > 0.0;
+        if (counting && neighborhoodCache.largestRadius() > countRadius) neighborhoodCache.clear();
+        if (neighborhoodCache.empty() && !counting) return;
+        double radius = counting ? countRadius : neighborhoodCache.largestRadius();
+        std::vector<int> queryIds(count);
+        for (int q = 0; q < count; ++q) queryIds[q] = first + q;
+        std::vector<int> offsets;
+        std::vector<int> found;
+        radiusSearchBatch(queryIds, radius, offsets, found);
+        for (int q = 0; q < count; ++q) {
+            int id = first + q;
+            for (int k = offsets[q]; k < offsets[q + 1]; ++k) {
+                int neighbor = found[k];
+                if (neighbor >= first && neighbor < first + count) continue;
+                neighborhoodCache.invalidate(neighbor);
+                if (counting && neighborCounts[neighbor] >= 0) ++neighborCounts[neighbor];
+            }
+            neighborhoodCache.invalidate(id);
+            if (counting) {
+                neighborCounts[id] = offsets[q + 1] - offsets[q];
+                neighborhoodCache.put(id, countRadius, std::vector<int>(found.begin() + offsets[q], found.begin() + offsets[q + 1]));
+            }
+        }
+    }
+
+    //Backends call this while a point being removed is still searchable
+    void pointRemoving(int id) {
+        updateAround(id, -1);
+    }
+
+private:
+    std::vector<int> clusterIds;
+    std::vector<char> visitedFlags;
+    DisjointSet clusterSets;
+    NeighborhoodCache neighborhoodCache;
+    std::vector<int> neighborCounts;
+    double countRadius = 0.0;
+    // Buffers updateAround and neighborCount reuse instead of allocating per call
+    struct UpdateScratch {
+        std::vector<int> around;
+        std::vector<char> inCount;
+        std::vector<int> counted;
+        std::vector<int> counting;
+    };
+    UpdateScratch updateScratch;
+
+    bool contains(int id) const {
+        return id >= 0 && id < static_cast<int>(clusterIds.size());
+    }
+
+    // One radius query around a point that arrives (delta 1) or leaves (delta -1):
+    // drops the cached neighborhoods of every point within the cached radius,
+    // moves the known counts of the points within the count radius by delta,
+    // and, on arrival, records the point's own count and neighborhood. Ids in
+    // [batchBegin, batchEnd) arrived together with id and are left alone: their
+    // own queries already see id.
+    void updateAround(int id, int delta, int batchBegin = 0, int batchEnd = 0) {
+        bool counting = countRadius > 0.0;
+        if (neighborhoodCache.empty() && !counting) return;
+        double radius = std::max(neighborhoodCache.largestRadius(), countRadius);
+        std::vector<int>& around = updateScratch.around;
+        std::vector<char>& inCount = updateScratch.inCount;
+        std::vector<int>& counted = updateScratch.counted;
+        if (counting) {
+            radiusSearchByIdSplit(id, radius, countRadius, around, inCount);
+        } else {
+            radiusSearchById(id, radius, around);
+            inCount.assign(around.size(), 0);
+        }
+        counted.clear();
+        for (size_t k = 0; k < around.size(); ++k) {
+            int neighbor = around[k];
+            if (inCount[k]) counted.push_back(neighbor);
+            if (neighbor == id || (neighbor >= batchBegin && neighbor < batchEnd)) continue;
+            neighborhoodCache.invalidate(neighbor);
+            if (inCount[k] && neighborCounts[neighbor] >= 0) neighborCounts[neighbor] += delta;
+        }
+        neighborhoodCache.invalidate(id);
+        if (!counting) return;
+        if (delta > 0) {
+            neighborCounts[id] = static_cast<int>(counted.size());
+            neighborhoodCache.put(id, countRadius, counted);
+        } else {
+            neighborCounts[id] = -1;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,156 @@
+// NeighborhoodCache.h
+#ifndef NEIGHBORHOODCACHE_H
+#define NEIGHBORHOODCACHE_H
+
+#include "Metrics.h"
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+// Eps-neighborhoods of stored points, keyed by point id, within a byte budget.
+// Entries live in a ring of slots swept by a CLOCK hand: a lookup sets the
+// entry's reference bit, and when an insertion would go over budget the hand
+// clears set bits and evicts the first entry it finds without one. The owning
+// index calls invalidate() for every point whose neighborhood an insert or
+// remove changed.
+class NeighborhoodCache {
+public:
+    struct Stats {
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+        size_t invalidations;
+        size_t entries;
+        size_t bytes;
+    };
+
+    explicit NeighborhoodCache(size_t budgetBytes = size_t(256) << 20) : budget(budgetBytes) {}
+
+    //Change the byte budget, evicting entries until the cache fits
+    void setBudget(size_t budgetBytes) {
+        budget = budgetBytes;
+        while (bytes > budget && evictOne()) {}
+    }
+
+    //Cached neighborhood of id at radius, or nullptr on a miss
+    const std::vector<int>* find(int id, double radius) {
+        int slot = id >= 0 && id < static_cast<int>(slotOf.size()) ? slotOf[id] : -1;
+        if (slot < 0 || slots[slot].radius != radius) {
+            ++misses;
+            METRIC_ADD(CacheMisses, 1);
+            return nullptr;
+        }
+        ++hits;
+        METRIC_ADD(CacheHits, 1);
+        slots[slot].referenced = true;
+        return &slots[slot].ids;
+    }
+
+    void put(int id, double radius, const std::vector<int>& ids) {
+        if (id < 0) return;
+        erase(id);
+        size_t cost = entryCost(ids.size());
+        if (cost > budget) return;
+        while (bytes + cost > budget && evictOne()) {}
+
+        int slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            slot = static_cast<int>(slots.size());
+            slots.emplace_back();
+        }
+        Entry& entry = slots[slot];
+        entry.id = id;
+        entry.radius = radius;
+        entry.ids.assign(ids.begin(), ids.end());
+        entry.referenced = false;
+        if (id >= static_cast<int>(slotOf.size())) slotOf.resize(id + 1, -1);
+        slotOf[id] = slot;
+        bytes += cost;
+        ++entries;
+        maxRadius = std::max(maxRadius, radius);
+    }
+
+    //Drop the cached neighborhood of id, if any
+    void invalidate(int id) {
+        if (erase(id)) ++invalidations;
+    }
+
+    void clear() {
+        slots.clear();
+        slotOf.clear();
+        freeSlots.clear();
+        hand = 0;
+        bytes = 0;
+        entries = 0;
+        maxRadius = 0.0;
+    }
+
+    bool empty() const { return entries == 0; }
+
+    //Largest radius any entry was cached for; an update farther than this away invalidates nothing
+    double largestRadius() const { return maxRadius; }
+
+    Stats stats() const {
+        return {hits, misses, evictions, invalidations, entries, bytes};
+    }
+
+private:
+    struct Entry {
+        int id = -1;
+        double radius = 0.0;
+        std::vector<int> ids;
+        bool referenced = false;
+    };
+
+    size_t budget;
+    std::vector<Entry> slots;
+    std::vector<int> slotOf;
+    std::vector<int> freeSlots;
+    size_t hand = 0;
+    size_t bytes = 0;
+    size_t entries = 0;
+    double maxRadius = 0.0;
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t invalidations = 0;
+
+    static size_t entryCost(size_t neighbors) {
+        return sizeof(Entry) + sizeof(int) + neighbors * sizeof(int);
+    }
+
+    bool erase(int id) {
+        int slot = id >= 0 && id < static_cast<int>(slotOf.size()) ? slotOf[id] : -1;
+        if (slot < 0) return false;
+        Entry& entry = slots[slot];
+        bytes -= entryCost(entry.ids.size());
+        --entries;
+        entry.id = -1;
+        std::vector<int>().swap(entry.ids);
+        slotOf[id] = -1;
+        freeSlots.push_back(slot);
+        return true;
+    }
+
+    //Advance the hand to the first unreferenced entry and evict it
+    bool evictOne() {
+        if (entries == 0) return false;
+        while (true) {
+            if (hand >= slots.size()) hand = 0;
+            Entry& entry = slots[hand++];
+            if (entry.id < 0) continue;
+            if (entry.referenced) {
+                entry.referenced = false;
+                continue;
+            }
+            erase(entry.id);
+            ++evictions;
+            return true;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,282 @@
+// NpyDataset.h
+#ifndef NPYDATASET_H
+#define NPYDATASET_H
+
+#include "ParallelFor.h"
+#include "MappedFile.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Embeddings as one contiguous row-major float32 matrix. Labels are interned:
+// row i is labelled labelName(labelId(i)), and sources without labels give -1.
+// A directory tree is enumerated and read in parallel, each file's payload
+// going straight into its rows of one preallocated buffer; a single .npy or
+// raw float32 file is memory-mapped and its rows are read in place.
+class NpyDataset {
+public:
+    //Every <base_dir>/<moviestar>/<movie>/*.npy, labelled by moviestar, in directory order
+    static NpyDataset fromDirectory(const std::string& base_dir, int threads = 0) {
+        namespace fs = std::filesystem;
+        threads = resolveThreadCount(threads);
+        NpyDataset dataset;
+        std::vector<fs::path> stars;
+        for (const auto& moviestar_entry : fs::directory_iterator(base_dir)) {
+            if (moviestar_entry.is_directory()) stars.push_back(moviestar_entry.path());
+        }
+
+        //Each star's subtree is walked by one worker; concatenating keeps the sequential order
+        std::vector<std::vector<std::string>> filesPerStar(stars.size());
+        parallelFor(threads, stars.size(), 1, [&](size_t s) {
+            for (const auto& moviename_entry : fs::directory_iterator(stars[s])) {
+                if (!moviename_entry.is_directory()) continue;
+                for (const auto& npy_file_entry : fs::directory_iterator(moviename_entry.path())) {
+                    if (npy_file_entry.path().extension() == ".npy") filesPerStar[s].push_back(npy_file_entry.path().string());
+                }
+            }
+        });
+        std::vector<Source> sources;
+        for (size_t s = 0; s < stars.size(); ++s) {
+            dataset.labelNames.push_back(stars[s].filename().string());
+            for (std::string& path : filesPerStar[s]) sources.emplace_back(std::move(path), static_cast<int>(s));
+        }
+
+        //Headers first, so every file's rows have a place before any payload is read
+        parallelFor(threads, sources.size(), 32, [&](size_t f) {
+            Source& source = sources[f];
+            int fd = ::open(source.path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                source.error = "cannot open " + source.path;
+                return;
+            }
+            try {
+                source.header = readHeader(fd, source.path);
+            } catch (const std::exception& e) {
+                source.error = e.what();
+            }
+            ::close(fd);
+        });
+        size_t rows = 0;
+        for (Source& source : sources) {
+            if (!source.error.empty()) throw std::runtime_error("NpyDataset: " + source.error);
+            if (dataset.dims == 0) dataset.dims = source.header.dims;
+            if (source.header.dims != dataset.dims) {
+                throw std::runtime_error("NpyDataset: " + source.path + " has " + std::to_string(source.header.dims) + " columns, expected " +
+                                         std::to_string(dataset.dims));
+            }
+            source.firstRow = rows;
+            rows += source.header.rows;
+        }
+
+        dataset.rows = rows;
+        dataset.storage.resize(rows * dataset.dims);
+        dataset.labelIds.resize(rows);
+        parallelFor(threads, sources.size(), 32, [&](size_t f) {
+            Source& source = sources[f];
+            size_t bytes = source.header.rows * dataset.dims * sizeof(float);
+            char* out = reinterpret_cast<char*>(dataset.storage.data() + source.firstRow * dataset.dims);
+            int fd = ::open(source.path.c_str(), O_RDONLY);
+            size_t done = 0;
+            while (fd >= 0 && done < bytes) {
+                ssize_t got = ::pread(fd, out + done, bytes - done, static_cast<off_t>(source.header.dataOffset + done));
+                if (got <= 0) break;
+                done += static_cast<size_t>(got);
+            }
+            if (fd >= 0) ::close(fd);
+            if (done != bytes) source.error = "cannot read " + source.path;
+            std::fill(dataset.labelIds.begin() + source.firstRow, dataset.labelIds.begin() + source.firstRow + source.header.rows, source.label);
+        });
+        for (const Source& source : sources) {
+            if (!source.error.empty()) throw std::runtime_error("NpyDataset: " + source.error);
+        }
+        return dataset;
+    }
+
+    //A single little-endian float32 .npy of shape (d) or (n, d), mapped and read in place
+    static NpyDataset fromNpyFile(const std::string& path) {
+        auto file = std::make_shared<const MappedFile>(path);
+        Header header = parseHeader(file->data(), file->size(), path);
+        if (header.dataOffset + header.rows * header.dims * sizeof(float) > file->size()) {
+            throw std::runtime_error("NpyDataset: " + path + " is truncated");
+        }
+        return mapped(file, header.dataOffset, header.rows, header.dims);
+    }
+
+    //A headerless file of float32 rows with dims columns, mapped and read in place
+    static NpyDataset fromRawFile(const std::string& path, size_t dims) {
+        auto file = std::make_shared<const MappedFile>(path);
+        if (dims == 0 || file->size() % (dims * sizeof(float)) != 0) {
+            throw std::runtime_error("NpyDataset: " + path + " is not a whole number of " + std::to_string(dims) + "-float rows");
+        }
+        return mapped(file, 0, file->size() / (dims * sizeof(float)), dims);
+    }
+
+    //Write the matrix as one (rows, dims) float32 .npy, which fromNpyFile maps back
+    void save(const std::string& path) const {
+        std::string dict = "{'descr': '<f4', 'fortran_order': False, 'shape': (" + std::to_string(rows) + ", " + std::to_string(dims) + "), }";
+        //Magic, version and length take 10 bytes; pad so the payload starts on a 64-byte boundary
+        size_t total = (10 + dict.size() + 1 + 63) / 64 * 64;
+        dict.append(total - 10 - dict.size() - 1, ' ');
+        dict.push_back('\n');
+        uint16_t length = static_cast<uint16_t>(dict.size());
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) throw std::runtime_error("NpyDataset: cannot create " + path);
+        const char preamble[8] = {'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0};
+        bool ok = std::fwrite(preamble, 1, 8, file) == 8 && std::fwrite(&length, 2, 1, file) == 1 &&
+                  std::fwrite(dict.data(), 1, dict.size(), file) == dict.size() &&
+                  std::fwrite(data(), sizeof(float), rows * dims, file) == rows * dims;
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok) throw std::runtime_error("NpyDataset: cannot write " + path);
+    }
+
+    size_t size() const { return rows; }
+    size_t dimensions() const { return dims; }
+    const float* data() const { return mapping ? mappedValues : storage.data(); }
+    const float* row(size_t i) const { return data() + i * dims; }
+
+    //Interned label of row i, or -1
+    int labelId(size_t i) const { return labelIds.empty() ? -1 : labelIds[i]; }
+    const std::string& labelName(int id) const { return labelNames[id]; }
+    size_t labelCount() const { return labelNames.size(); }
+
+    //One label string per row, empty for unlabelled rows
+    std::vector<std::string> labelStrings() const {
+        std::vector<std::string> labels(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            int id = labelId(i);
+            if (id >= 0) labels[i] = labelNames[id];
+        }
+        return labels;
+    }
+
+    //Rows as double vectors, the form the clustering classes take
+    std::vector<std::vector<double>> toDouble() const {
+        std::vector<std::vector<double>> result(rows);
+        for (size_t i = 0; i < rows; ++i) result[i].assign(row(i), row(i) + dims);
+        return result;
+    }
+
+private:
+    struct Header {
+        size_t dataOffset = 0;
+        size_t rows = 0;
+        size_t dims = 0;
+    };
+
+    struct Source {
+        Source(std::string path, int label) : path(std::move(path)), label(label) {}
+
+        std::string path;
+        int label;
+        Header header;
+        size_t firstRow = 0;
+        std::string error;
+    };
+
+    size_t rows = 0;
+    size_t dims = 0;
+    std::vector<float> storage;
+    std::shared_ptr<const MappedFile> mapping;
+    const float* mappedValues = nullptr;
+    std::vector<int> labelIds;
+    std::vector<std::string> labelNames;
+
+    static NpyDataset mapped(const std::shared_ptr<const MappedFile>& file, size_t offset, size_t rows, size_t dims) {
+        if (offset % alignof(float) != 0) throw std::runtime_error("NpyDataset: misaligned payload");
+        NpyDataset dataset;
+        dataset.mapping = file;
+        dataset.mappedValues = reinterpret_cast<const float*>(file->data() + offset);
+        dataset.rows = rows;
+        dataset.dims = dims;
+        return dataset;
+    }
+
+    //Header of an open .npy; reads more than the first block only for long headers
+    static Header readHeader(int fd, const std::string& path) {
+        std::vector<char> bytes(256);
+        ssize_t got = ::pread(fd, bytes.data(), bytes.size(), 0);
+        if (got < 12) throw std::runtime_error(path + " is not a .npy file");
+        bytes.resize(static_cast<size_t>(got));
+        size_t needed = headerEnd(bytes.data(), bytes.size(), path);
+        if (needed > bytes.size()) {
+            bytes.resize(needed);
+            if (::pread(fd, bytes.data(), needed, 0) != static_cast<ssize_t>(needed)) throw std::runtime_error(path + " has a truncated header");
+        }
+        return parseHeader(bytes.data(), bytes.size(), path);
+    }
+
+    //Offset of the payload: magic, version, then a 2-byte (v1) or 4-byte (v2, v3) header length
+    static size_t headerEnd(const char* bytes, size_t size, const std::string& path) {
+        if (size < 12 || std::memcmp(bytes, "\x93NUMPY", 6) != 0) throw std::runtime_error(path + " is not a .npy file");
+        unsigned char major = static_cast<unsigned char>(bytes[6]);
+        const unsigned char* length = reinterpret_cast<const unsigned char*>(bytes + 8);
+        if (major == 1) return 10 + (length[0] | (length[1] << 8));
+        if (major == 2 || major == 3) return 12 + (length[0] | (length[1] << 8) | (length[2] << 16) | (static_cast<size_t>(length[3]) << 24));
+        throw std::runtime_error(path + " has unsupported .npy version " + std::to_string(major));
+    }
+
+    static Header parseHeader(const char* bytes, size_t size, const std::string& path) {
+        Header header;
+        header.dataOffset = headerEnd(bytes, size, path);
+        if (header.dataOffset > size) throw std::runtime_error(path + " has a truncated header");
+        size_t start = bytes[6] == 1 ? 10 : 12;
+        std::string dict(bytes + start, bytes + header.dataOffset);
+
+        auto valueAfter = [&](const std::string& key) {
+            size_t at = dict.find("'" + key + "'");
+            if (at == std::string::npos) throw std::runtime_error(path + " header has no " + key);
+            return dict.find(':', at) + 1;
+        };
+        size_t descr = dict.find('\'', valueAfter("descr"));
+        if (dict.compare(descr, 5, "'<f4'") != 0) throw std::runtime_error(path + " is not little-endian float32");
+        size_t fortran = valueAfter("fortran_order");
+        bool fortranOrder = dict.find("True", fortran) == dict.find_first_not_of(' ', fortran);
+
+        size_t open = dict.find('(', valueAfter("shape"));
+        size_t close = dict.find(')', open);
+        std::vector<size_t> shape;
+        for (size_t at = open + 1; at < close;) {
+            size_t digit = dict.find_first_of("0123456789", at);
+            if (digit == std::string::npos || digit >= close) break;
+            size_t end = dict.find_first_not_of("0123456789", digit);
+            shape.push_back(std::stoull(dict.substr(digit, end - digit)));
+            at = end;
+        }
+        if (shape.empty()) throw std::runtime_error(path + " holds a scalar");
+        header.dims = shape.back();
+        header.rows = 1;
+        for (size_t k = 0; k + 1 < shape.size(); ++k) header.rows *= shape[k];
+        if (fortranOrder && header.rows > 1 && header.dims > 1) throw std::runtime_error(path + " is in Fortran order");
+        return header;
+    }
+};
+
+// Function to convert float data to double data
+inline std::vector<std::vector<double>> convertToDouble(const std::vector<std::vector<float>>& data) {
+    std::vector<std::vector<double>> result;
+    result.reserve(data.size());
+    for (const auto& vec : data) {
+        result.emplace_back(vec.begin(), vec.end());
+    }
+    return result;
+}
+
+// Walk <base_dir>/<moviestar>/<movie>/*.npy and load every embedding, labelled by moviestar.
+// Row-per-vector form of NpyDataset::fromDirectory for callers that want one.
+inline std::vector<std::vector<float>> load_npy_files(const std::string& base_dir, std::vector<std::string>& labels) {
+    NpyDataset dataset = NpyDataset::fromDirectory(base_dir);
+    std::vector<std::string> rowLabels = dataset.labelStrings();
+    labels.insert(labels.end(), rowLabels.begin(), rowLabels.end());
+    std::vector<std::vector<float>> data(dataset.size());
+    for (size_t i = 0; i < dataset.size(); ++i) data[i].assign(dataset.row(i), dataset.row(i) + dataset.dimensions());
+    return data;
+}
+
+#endif
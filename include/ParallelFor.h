@@ -0,0 +1,37 @@
+// ParallelFor.h
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+
+//Run body(i) for i in [0, n) on `threads` threads pulling chunks of `chunk` indices off a shared counter
+template <typename Body>
+inline void parallelFor(int threads, size_t n, size_t chunk, Body body) {
+    if (threads <= 1 || n <= chunk) {
+        for (size_t i = 0; i < n; ++i) body(i);
+        return;
+    }
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            size_t begin;
+            while ((begin = next.fetch_add(chunk)) < n) {
+                size_t end = std::min(n, begin + chunk);
+                for (size_t i = begin; i < end; ++i) body(i);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+}
+
+//Threads to use for a requested count; 0 or less means every hardware thread
+inline int resolveThreadCount(int threads) {
+    return threads > 0 ? threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+#endif
@@ -0,0 +1,118 @@
+// PointArena.h
+#ifndef POINTARENA_H
+#define POINTARENA_H
+
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <algorithm>
+
+// Contiguous, cache-line aligned, row-major storage for fixed-dimension points.
+// Row i holds the coordinates of point id i, padded so every row starts on a
+// cache line boundary. An arena can also be a read-only view of rows someone
+// else keeps alive (a mapped snapshot); the first write copies them.
+class PointArena {
+public:
+    static constexpr size_t alignment = 64;
+
+    explicit PointArena(int dimensions)
+        : dimensions(dimensions), stride(paddedStride(dimensions)), rows(0), capacity(0), data(nullptr) {}
+
+    ~PointArena() {
+        if (owned) std::free(data);
+    }
+
+    //Arena reading count rows laid out with this arena's stride from memory the caller keeps alive
+    static PointArena view(int dimensions, const double* rows, size_t count) {
+        PointArena arena(dimensions);
+        arena.data = const_cast<double*>(rows);
+        arena.rows = arena.capacity = count;
+        arena.owned = false;
+        return arena;
+    }
+
+    PointArena(const PointArena& other)
+        : dimensions(other.dimensions), stride(other.stride), rows(0), capacity(0), data(nullptr) {
+        reserve(other.rows);
+        if (other.rows) std::memcpy(data, other.data, other.rows * stride * sizeof(double));
+        rows = other.rows;
+    }
+
+    PointArena(PointArena&& other) noexcept
+        : dimensions(other.dimensions), stride(other.stride), rows(other.rows), capacity(other.capacity), data(other.data), owned(other.owned) {
+        other.rows = other.capacity = 0;
+        other.data = nullptr;
+        other.owned = true;
+    }
+
+    PointArena& operator=(PointArena other) noexcept {
+        std::swap(dimensions, other.dimensions);
+        std::swap(stride, other.stride);
+        std::swap(rows, other.rows);
+        std::swap(capacity, other.capacity);
+        std::swap(data, other.data);
+        std::swap(owned, other.owned);
+        return *this;
+    }
+
+    //Store the point under row `id`, growing the buffer if needed
+    void set(size_t id, const std::vector<double>& point) {
+        if (!owned) reallocate(std::max(id + 1, capacity));
+        if (id >= capacity) reserve(std::max(id + 1, capacity * 2));
+        if (id >= rows) {
+            std::memset(data + rows * stride, 0, (id + 1 - rows) * stride * sizeof(double));
+            rows = id + 1;
+        }
+        std::memcpy(data + id * stride, point.data(), dimensions * sizeof(double));
+    }
+
+    void reserve(size_t n) {
+        if (n > capacity) reallocate(n);
+    }
+
+    const double* row(size_t id) const { return data + id * stride; }
+
+    //True unless this is a view of someone else's rows
+    bool ownsRows() const { return owned; }
+
+    std::vector<double> point(size_t id) const {
+        return std::vector<double>(row(id), row(id) + dimensions);
+    }
+
+    size_t size() const { return rows; }
+    int dims() const { return dimensions; }
+    size_t rowStride() const { return stride; }
+
+    //Bytes held by the coordinate buffer (none for a view)
+    size_t memoryUsage() const { return owned ? capacity * stride * sizeof(double) : 0; }
+
+private:
+    int dimensions;
+    size_t stride;
+    size_t rows;
+    size_t capacity;
+    double* data;
+    bool owned = true;
+
+    //Move the rows into an owned buffer of n rows
+    void reallocate(size_t n) {
+        size_t bytes = std::max<size_t>(n, 1) * stride * sizeof(double);
+        double* grown = static_cast<double*>(std::aligned_alloc(alignment, bytes));
+        if (!grown) throw std::bad_alloc();
+        if (rows) std::memcpy(grown, data, rows * stride * sizeof(double));
+        if (owned) std::free(data);
+        data = grown;
+        capacity = std::max<size_t>(n, 1);
+        owned = true;
+    }
+
+    static size_t paddedStride(int dimensions) {
+        size_t perLine = alignment / sizeof(double);
+        return (static_cast<size_t>(dimensions) + perLine - 1) / perLine * perLine;
+    }
+};
+
+#endif
@@ -0,0 +1,127 @@
+// ShardTransport.h
+#ifndef SHARDTRANSPORT_H
+#define SHARDTRANSPORT_H
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+// Messages between the shards of a ShardedINCDBSCAN and its coordinator.
+// A message is a type tag, the sender's endpoint and a flat byte payload, so
+// a transport only moves bytes and one over sockets or pipes can replace
+// LocalTransport without touching the clustering. Endpoints are numbered
+// 0..endpoints-1.
+struct ShardMessage {
+    int type = 0;
+    int from = 0;
+    std::vector<char> payload;
+};
+
+class ShardTransport {
+public:
+    virtual ~ShardTransport() = default;
+    virtual void send(int to, ShardMessage message) = 0;
+    //Block until a message for endpoint arrives
+    virtual ShardMessage receive(int endpoint) = 0;
+};
+
+//In-process transport: one mailbox per endpoint
+class LocalTransport : public ShardTransport {
+public:
+    explicit LocalTransport(int endpoints) : mailboxes(endpoints) {
+        for (auto& mailbox : mailboxes) mailbox = std::make_unique<Mailbox>();
+    }
+
+    void send(int to, ShardMessage message) override {
+        Mailbox& mailbox = *mailboxes.at(to);
+        {
+            std::lock_guard<std::mutex> lock(mailbox.mutex);
+            mailbox.messages.push_back(std::move(message));
+        }
+        mailbox.ready.notify_one();
+    }
+
+    ShardMessage receive(int endpoint) override {
+        Mailbox& mailbox = *mailboxes.at(endpoint);
+        std::unique_lock<std::mutex> lock(mailbox.mutex);
+        mailbox.ready.wait(lock, [&] { return !mailbox.messages.empty(); });
+        ShardMessage message = std::move(mailbox.messages.front());
+        mailbox.messages.pop_front();
+        return message;
+    }
+
+private:
+    struct Mailbox {
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<ShardMessage> messages;
+    };
+    std::vector<std::unique_ptr<Mailbox>> mailboxes;
+};
+
+//Appends trivially copyable values and arrays to a payload
+class PayloadWriter {
+public:
+    explicit PayloadWriter(std::vector<char>& bytes) : bytes(bytes) {}
+
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "payload values must be trivially copyable");
+        const char* raw = reinterpret_cast<const char*>(&value);
+        bytes.insert(bytes.end(), raw, raw + sizeof(T));
+    }
+
+    //Count followed by the elements
+    template <typename T>
+    void putArray(const T* values, size_t count) {
+        put<uint64_t>(count);
+        const char* raw = reinterpret_cast<const char*>(values);
+        bytes.insert(bytes.end(), raw, raw + count * sizeof(T));
+    }
+
+    template <typename T>
+    void putArray(const std::vector<T>& values) {
+        putArray(values.data(), values.size());
+    }
+
+private:
+    std::vector<char>& bytes;
+};
+
+//Reads back what PayloadWriter wrote, in the same order
+class PayloadReader {
+public:
+    explicit PayloadReader(const std::vector<char>& bytes) : bytes(bytes) {}
+
+    template <typename T>
+    T get() {
+        T value;
+        take(&value, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    std::vector<T> getArray() {
+        std::vector<T> values(get<uint64_t>());
+        take(values.data(), values.size() * sizeof(T));
+        return values;
+    }
+
+private:
+    const std::vector<char>& bytes;
+    size_t offset = 0;
+
+    void take(void* out, size_t size) {
+        if (offset + size > bytes.size()) throw std::runtime_error("ShardMessage: payload too short");
+        std::memcpy(out, bytes.data() + offset, size);
+        offset += size;
+    }
+};
+
+#endif
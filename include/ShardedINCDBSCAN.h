@@ -0,0 +1,430 @@
+// ShardedINCDBSCAN.h
+#ifndef SHARDEDINCDBSCAN_H
+#define SHARDEDINCDBSCAN_H
+
+#include "INCDBSCAN.h"
+#include "KDTree.h"
+#include "ShardTransport.h"
+#include <vector>
+#include <thread>
+#include <random>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+
+// Splits space into slabs along one seeded random direction. Slab edges sit
+// at quantiles of the projections of a sample, so the shards start out with
+// about the same number of points. Projection onto a unit vector never grows
+// a euclidean distance, so every point within eps of a point in slab s lies
+// within eps of slab s along the direction: that margin is the halo.
+class SlabPartitioner {
+public:
+    SlabPartitioner(int dimensions, int shards, unsigned seed = 1) : shards(shards), direction(dimensions) {
+        std::mt19937_64 g(seed);
+        std::normal_distribution<double> normal(0.0, 1.0);
+        double norm = 0.0;
+        for (double& x : direction) {
+            x = normal(g);
+            norm += x * x;
+        }
+        norm = std::sqrt(norm);
+        for (double& x : direction) x /= norm;
+    }
+
+    //Put the slab edges at the quantiles of the sample's projections
+    void fit(const std::vector<std::vector<double>>& sample) {
+        std::vector<double> projections;
+        projections.reserve(sample.size());
+        for (const auto& point : sample) projections.push_back(project(point));
+        std::sort(projections.begin(), projections.end());
+        edges.clear();
+        for (int s = 1; s < shards; ++s) {
+            edges.push_back(projections.empty() ? 0.0 : projections[projections.size() * s / shards]);
+        }
+        isFitted = true;
+    }
+
+    bool fitted() const { return isFitted; }
+
+    double project(const std::vector<double>& point) const {
+        return Distance::dot(point.data(), direction.data(), direction.size());
+    }
+
+    //Shard whose slab holds projection x
+    int owner(double x) const {
+        return static_cast<int>(std::upper_bound(edges.begin(), edges.end(), x) - edges.begin());
+    }
+
+    //Shards other than owner(x) whose slab lies within eps of x
+    void halo(double x, double eps, std::vector<int>& result) const {
+        result.clear();
+        int own = owner(x);
+        for (int s = own - 1; s >= 0 && x - edges[s] <= eps; --s) result.push_back(s);
+        for (int s = own + 1; s < shards && edges[s - 1] - x <= eps; ++s) result.push_back(s);
+    }
+
+private:
+    int shards;
+    std::vector<double> direction;
+    std::vector<double> edges;
+    bool isFitted = false;
+};
+
+// INCDBSCAN over spatial shards. Each shard runs its own index and INCDBSCAN
+// on a worker thread and holds the points of its slab plus, as halo copies,
+// the points within eps of it, so the neighbor count, and so the core flag,
+// of every point it owns is exact. A shard only ever finds true core points
+// core, and its local clusters join true cores only. The coordinator stitches
+// local clusters into global ones: each owner reports its labeled cores, the
+// shards holding them as halo report which of their own labeled cores are
+// within eps of one, and each such pair unites the two local clusters in a
+// union-find keyed by (shard, local cluster id). Local merges that retire a
+// reported id are reported too. Labeled cores are joined exactly as INCDBSCAN
+// joins them in one process, but which old cores get a label can differ.
+// INCDBSCAN labels an unlabeled old core only when a new core of the batch
+// reaches it through unlabeled cores, and stops at labeled ones. A shard walks
+// only the points it holds, and its halo copies carry its own labels:
+//  - a chain that leaves the owner's slab, or passes a halo copy whose count
+//    falls short, is not walked, so the core can stay unlabeled here while
+//    INCDBSCAN labels it;
+//  - a halo copy still unlabeled in its shard, though its owner labeled it,
+//    does not stop the walk, so a later batch can label cores past it that
+//    INCDBSCAN leaves unlabeled.
+// Like INCDBSCAN, points that are not core stay noise.
+//
+// Shards talk to the coordinator only through ShardMessage payloads over a
+// ShardTransport (LocalTransport by default: shards are threads), so shards
+// in other processes need only another transport. Shards are endpoints
+// 0..shards-1, the coordinator is endpoint shards. Slabs assume the euclidean
+// metric.
+class ShardedINCDBSCAN {
+public:
+    using IndexFactory = std::function<std::unique_ptr<NeighborIndex>(int dimensions)>;
+
+    struct ShardStats {
+        int owned = 0;
+        int halo = 0;
+    };
+
+    ShardedINCDBSCAN(double eps, int minPts, int dimensions, int shards, unsigned seed = 1, IndexFactory factory = nullptr,
+                     std::shared_ptr<ShardTransport> transport = nullptr)
+        : eps(eps), minPts(minPts), dimensions(dimensions), shards(shards), partitioner(dimensions, shards, seed),
+          transport(transport ? transport : std::make_shared<LocalTransport>(shards + 1)), stats(shards) {
+        if (!factory) factory = [](int d) { return std::make_unique<KDTree>(d); };
+        for (int s = 0; s < shards; ++s) {
+            auto worker = std::make_shared<Worker>(s, shards, eps, minPts, dimensions, factory(dimensions), *this->transport);
+            threads.emplace_back([worker] { worker->run(); });
+        }
+    }
+
+    ~ShardedINCDBSCAN() {
+        for (int s = 0; s < shards; ++s) transport->send(s, ShardMessage{Stop, shards, {}});
+        for (auto& thread : threads) thread.join();
+    }
+
+    ShardedINCDBSCAN(const ShardedINCDBSCAN&) = delete;
+    ShardedINCDBSCAN& operator=(const ShardedINCDBSCAN&) = delete;
+
+    //Cluster the next batch; its points get global ids size(), size() + 1, ...
+    //The first batch also places the slab edges.
+    void cluster(const std::vector<std::vector<double>>& points) {
+        if (!partitioner.fitted()) partitioner.fit(points);
+
+        //Each point goes to its owner and, as a halo copy, to the shards within eps
+        std::vector<std::vector<int>> ids(shards);
+        std::vector<std::vector<char>> owned(shards);
+        std::vector<std::vector<double>> coordinates(shards);
+        std::vector<int> haloShards;
+        for (const auto& point : points) {
+            int id = nextGlobalId++;
+            double x = partitioner.project(point);
+            int owner = partitioner.owner(x);
+            partitioner.halo(x, eps, haloShards);
+            auto place = [&](int s, bool isOwner) {
+                ids[s].push_back(id);
+                owned[s].push_back(isOwner);
+                coordinates[s].insert(coordinates[s].end(), point.begin(), point.end());
+                ++(isOwner ? stats[s].owned : stats[s].halo);
+            };
+            place(owner, true);
+            for (int s : haloShards) place(s, false);
+            if (!haloShards.empty()) haloHolders[id] = haloShards;
+        }
+        for (int s = 0; s < shards; ++s) {
+            ShardMessage message{Insert, shards, {}};
+            PayloadWriter writer(message.payload);
+            writer.putArray(ids[s]);
+            writer.putArray(owned[s]);
+            writer.putArray(coordinates[s]);
+            transport->send(s, std::move(message));
+        }
+
+        //Newly labeled cores get their key; the shards holding them as halo look for their own cores nearby
+        std::vector<std::vector<int>> haloCores(shards);
+        for (int r = 0; r < shards; ++r) {
+            ShardMessage reply = receive(Inserted);
+            PayloadReader reader(reply.payload);
+            std::vector<int> coreIds = reader.getArray<int>();
+            std::vector<int> coreRoots = reader.getArray<int>();
+            std::vector<int> retired = reader.getArray<int>();
+            std::vector<int> roots = reader.getArray<int>();
+            for (size_t k = 0; k < retired.size(); ++k) unite(key(reply.from, retired[k]), key(reply.from, roots[k]));
+            for (size_t k = 0; k < coreIds.size(); ++k) {
+                coreKey[coreIds[k]] = key(reply.from, coreRoots[k]);
+                auto holders = haloHolders.find(coreIds[k]);
+                if (holders == haloHolders.end()) continue;
+                for (int s : holders->second) haloCores[s].push_back(coreIds[k]);
+            }
+        }
+        for (int s = 0; s < shards; ++s) {
+            ShardMessage message{Stitch, shards, {}};
+            PayloadWriter writer(message.payload);
+            writer.putArray(haloCores[s]);
+            transport->send(s, std::move(message));
+        }
+        for (int r = 0; r < shards; ++r) {
+            ShardMessage reply = receive(Edges);
+            PayloadReader reader(reply.payload);
+            std::vector<int> roots = reader.getArray<int>();
+            std::vector<int> haloIds = reader.getArray<int>();
+            for (size_t k = 0; k < roots.size(); ++k) unite(key(reply.from, roots[k]), coreKey.at(haloIds[k]));
+        }
+    }
+
+    //Global cluster of every point by global id (-1 for noise), numbered 0.. in order of first point
+    void clusterLabels(std::vector<int>& labels) {
+        for (int s = 0; s < shards; ++s) transport->send(s, ShardMessage{Labels, shards, {}});
+        std::vector<int64_t> keys(nextGlobalId, -1);
+        for (int r = 0; r < shards; ++r) {
+            ShardMessage reply = receive(LabelsReply);
+            PayloadReader reader(reply.payload);
+            std::vector<int> ids = reader.getArray<int>();
+            std::vector<int> roots = reader.getArray<int>();
+            for (size_t k = 0; k < ids.size(); ++k) {
+                if (roots[k] >= 0) keys[ids[k]] = find(key(reply.from, roots[k]));
+            }
+        }
+        std::unordered_map<int64_t, int> dense;
+        labels.assign(nextGlobalId, -1);
+        for (int id = 0; id < nextGlobalId; ++id) {
+            if (keys[id] < 0) continue;
+            auto it = dense.emplace(keys[id], static_cast<int>(dense.size())).first;
+            labels[id] = it->second;
+        }
+    }
+
+    int size() const { return nextGlobalId; }
+
+    //Points owned and halo copies held per shard
+    const std::vector<ShardStats>& shardStats() const { return stats; }
+
+private:
+    enum MessageType { Insert, Inserted, Stitch, Edges, Labels, LabelsReply, Stop };
+
+    // One shard: its index and INCDBSCAN, local ids 0.. in arrival order
+    class Worker {
+    public:
+        Worker(int shard, int coordinator, double eps, int minPts, int dimensions, std::unique_ptr<NeighborIndex> index, ShardTransport& transport)
+            : shard(shard), coordinator(coordinator), eps(eps), minPts(minPts), dimensions(dimensions), index(std::move(index)),
+              incdbscan(eps, minPts, *this->index), transport(transport) {}
+
+        void run() {
+            while (true) {
+                ShardMessage message = transport.receive(shard);
+                switch (message.type) {
+                case Insert: insert(message); break;
+                case Stitch: stitch(message); break;
+                case Labels: labels(); break;
+                default: return;
+                }
+            }
+        }
+
+    private:
+        int shard;
+        int coordinator;
+        double eps;
+        int minPts;
+        int dimensions;
+        std::unique_ptr<NeighborIndex> index;
+        INCDBSCAN incdbscan;
+        ShardTransport& transport;
+        int nextClusterId = 0;
+
+        std::vector<int> globalIds;               // local id -> global id
+        std::vector<char> owned;                  // local id is owned, not a halo copy
+        std::vector<char> reported;               // owned core whose key the coordinator has
+        std::vector<char> knownCore;              // halo copy the owner reported as a labeled core
+        std::vector<char> pending;                // owned core still without a label
+        std::unordered_map<int, int> localIds;    // global id -> local id
+        std::vector<int> pendingIds;
+        std::vector<int> reportedThisBatch;
+        std::vector<int> exported;                // local cluster ids the coordinator has seen
+        std::vector<int> neighbors;
+
+        void insert(const ShardMessage& message) {
+            PayloadReader reader(message.payload);
+            std::vector<int> ids = reader.getArray<int>();
+            std::vector<char> ownedFlags = reader.getArray<char>();
+            std::vector<double> coordinates = reader.getArray<double>();
+            int first = static_cast<int>(globalIds.size());
+            std::vector<std::vector<double>> points(ids.size());
+            for (size_t k = 0; k < ids.size(); ++k) {
+                points[k].assign(coordinates.begin() + k * dimensions, coordinates.begin() + (k + 1) * dimensions);
+                localIds[ids[k]] = first + static_cast<int>(k);
+                globalIds.push_back(ids[k]);
+                owned.push_back(ownedFlags[k]);
+            }
+            reported.resize(globalIds.size(), 0);
+            knownCore.resize(globalIds.size(), 0);
+            pending.resize(globalIds.size(), 0);
+            if (!points.empty()) {
+                incdbscan.cluster(points, nextClusterId, first);
+                incdbscan.getLastClusterId(nextClusterId);
+            }
+
+            //Owned points that may have become labeled cores: the new ones, their neighbors, and cores still unlabeled
+            std::vector<int> coreIds, coreRoots;
+            reportedThisBatch.clear();
+            auto consider = [&](int local) {
+                if (!owned[local] || reported[local] || !index->isCore(local, eps, minPts)) return;
+                int root = index->getClusterIdById(local);
+                if (root < 0) {
+                    if (!pending[local]) pendingIds.push_back(local);
+                    pending[local] = 1;
+                    return;
+                }
+                reported[local] = 1;
+                pending[local] = 0;
+                reportedThisBatch.push_back(local);
+                coreIds.push_back(globalIds[local]);
+                coreRoots.push_back(root);
+                exported.push_back(root);
+            };
+            for (int local = first; local < static_cast<int>(globalIds.size()); ++local) {
+                consider(local);
+                index->radiusSearchByIdUsingCache(local, eps, neighbors);
+                for (int neighbor : neighbors) consider(neighbor);
+            }
+            std::vector<int> stillPending;
+            for (int local : pendingIds) {
+                consider(local);
+                if (pending[local]) stillPending.push_back(local);
+            }
+            pendingIds.swap(stillPending);
+
+            ShardMessage reply{Inserted, shard, {}};
+            PayloadWriter writer(reply.payload);
+            writer.putArray(coreIds);
+            writer.putArray(coreRoots);
+            std::vector<int> retired, roots;
+            retire(retired, roots);
+            writer.putArray(retired);
+            writer.putArray(roots);
+            transport.send(coordinator, std::move(reply));
+        }
+
+        //Reported cluster ids that local merges folded into another id since the last batch
+        void retire(std::vector<int>& retired, std::vector<int>& roots) {
+            std::sort(exported.begin(), exported.end());
+            exported.erase(std::unique(exported.begin(), exported.end()), exported.end());
+            for (int& clusterId : exported) {
+                int root = index->resolveClusterId(clusterId);
+                if (root == clusterId) continue;
+                retired.push_back(clusterId);
+                roots.push_back(root);
+                clusterId = root;
+            }
+        }
+
+        //Pairs of an owned labeled core and a halo copy of a labeled core within eps
+        void stitch(const ShardMessage& message) {
+            PayloadReader reader(message.payload);
+            std::vector<int> haloCores = reader.getArray<int>();
+            std::vector<int> roots, haloIds;
+            for (int global : haloCores) {
+                int halo = localIds.at(global);
+                knownCore[halo] = 1;
+                index->radiusSearchByIdUsingCache(halo, eps, neighbors);
+                for (int neighbor : neighbors) {
+                    if (!owned[neighbor] || !reported[neighbor]) continue;
+                    roots.push_back(index->getClusterIdById(neighbor));
+                    haloIds.push_back(global);
+                }
+            }
+            for (int local : reportedThisBatch) {
+                index->radiusSearchByIdUsingCache(local, eps, neighbors);
+                for (int neighbor : neighbors) {
+                    if (owned[neighbor] || !knownCore[neighbor]) continue;
+                    roots.push_back(index->getClusterIdById(local));
+                    haloIds.push_back(globalIds[neighbor]);
+                }
+            }
+            exported.insert(exported.end(), roots.begin(), roots.end());
+
+            ShardMessage reply{Edges, shard, {}};
+            PayloadWriter writer(reply.payload);
+            writer.putArray(roots);
+            writer.putArray(haloIds);
+            transport.send(coordinator, std::move(reply));
+        }
+
+        void labels() {
+            std::vector<int> ids, roots;
+            for (size_t local = 0; local < globalIds.size(); ++local) {
+                if (!owned[local]) continue;
+                ids.push_back(globalIds[local]);
+                roots.push_back(index->getClusterIdById(static_cast<int>(local)));
+            }
+            ShardMessage reply{LabelsReply, shard, {}};
+            PayloadWriter writer(reply.payload);
+            writer.putArray(ids);
+            writer.putArray(roots);
+            transport.send(coordinator, std::move(reply));
+        }
+    };
+
+    double eps;
+    int minPts;
+    int dimensions;
+    int shards;
+    SlabPartitioner partitioner;
+    std::shared_ptr<ShardTransport> transport;
+    std::vector<std::thread> threads;
+    std::vector<ShardStats> stats;
+
+    int nextGlobalId = 0;
+    std::unordered_map<int, std::vector<int>> haloHolders; // global id -> shards holding a halo copy
+    std::unordered_map<int, int64_t> coreKey;              // global id of a labeled core -> its owner's cluster key
+    std::unordered_map<int64_t, int64_t> parent;           // union-find over cluster keys
+
+    static int64_t key(int shard, int clusterId) {
+        return (static_cast<int64_t>(shard) << 32) | static_cast<uint32_t>(clusterId);
+    }
+
+    int64_t find(int64_t k) {
+        auto it = parent.find(k);
+        if (it == parent.end()) return k;
+        int64_t root = find(it->second);
+        it->second = root;
+        return root;
+    }
+
+    void unite(int64_t a, int64_t b) {
+        a = find(a);
+        b = find(b);
+        if (a != b) parent[std::max(a, b)] = std::min(a, b);
+    }
+
+    ShardMessage receive(int type) {
+        ShardMessage message = transport->receive(shards);
+        if (message.type != type) throw std::runtime_error("ShardedINCDBSCAN: unexpected message from shard " + std::to_string(message.from));
+        return message;
+    }
+};
+
+#endif
@@ -0,0 +1,239 @@
+// Snapshot.h
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "ArenaKDTree.h"
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+// Binary snapshot of an ArenaKDTree and the clustering state on top of it:
+// point rows, the node pool, removed flags, cluster ids (merges resolved),
+// visited flags, eps-neighbor counts (so core flags) and nextClusterId. The
+// file is a 128-byte header followed by sections on 64-byte boundaries, laid
+// out exactly as the tree holds them in memory, so loading maps the file and
+// the tree searches the mapped rows and nodes in place; only the per-point
+// state arrays are copied. The header carries a format version, a byte order
+// mark and a checksum of the whole file.
+class Snapshot {
+public:
+    static constexpr uint32_t formatVersion = 1;
+
+    //Write the tree and its clustering state to path (through a temporary file renamed into place)
+    static void save(const ArenaKDTree& tree, int nextClusterId, const std::string& path) {
+        std::vector<int> clusters;
+        std::vector<char> visited;
+        std::vector<int> counts;
+        Header header = {};
+        tree.exportPointState(clusters, visited, counts, header.countRadius);
+
+        size_t points = tree.arena.size();
+        if (tree.removed.size() != points || clusters.size() != points) throw std::runtime_error("Snapshot: per-point state out of step with the rows");
+        std::memcpy(header.magic, magic, sizeof(header.magic));
+        header.version = formatVersion;
+        header.byteOrder = byteOrderMark;
+        header.dimensions = tree.dimensions;
+        header.root = tree.root;
+        header.live = tree.live;
+        header.nextClusterId = nextClusterId;
+        header.points = points;
+        header.stride = tree.arena.rowStride();
+        header.nodes = tree.mappedPool ? tree.mappedNodes : tree.pool.size();
+
+        uint64_t offset = sizeof(Header);
+        auto place = [&](uint64_t& sectionOffset, uint64_t bytes) {
+            sectionOffset = offset;
+            offset = aligned(offset + bytes);
+        };
+        place(header.rowsOffset, points * header.stride * sizeof(double));
+        place(header.nodesOffset, header.nodes * sizeof(ArenaKDTree::Node));
+        place(header.removedOffset, points);
+        place(header.clustersOffset, points * sizeof(int32_t));
+        place(header.visitedOffset, points);
+        place(header.countsOffset, points * sizeof(int32_t));
+        header.fileSize = offset;
+
+        std::string temporary = path + ".tmp";
+        std::FILE* file = std::fopen(temporary.c_str(), "wb");
+        if (!file) throw std::runtime_error("Snapshot: cannot create " + temporary);
+        Writer writer{file, Checksum(), 0, true};
+        writer.write(&header, sizeof(Header));
+        writer.section(points ? tree.arena.row(0) : nullptr, points * header.stride * sizeof(double));
+        writer.section(tree.mappedPool ? tree.mappedPool : tree.pool.data(), header.nodes * sizeof(ArenaKDTree::Node));
+        writer.section(tree.removed.data(), points);
+        writer.section(clusters.data(), points * sizeof(int32_t));
+        writer.section(visited.data(), points);
+        writer.section(counts.data(), points * sizeof(int32_t));
+
+        //The checksum covers the file with its own field zeroed, then goes into the header
+        header.checksum = writer.hash.value();
+        bool written = writer.ok && std::fseek(file, 0, SEEK_SET) == 0 &&
+                       std::fwrite(&header, sizeof(Header), 1, file) == 1;
+        written = std::fclose(file) == 0 && written;
+        if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+            std::remove(temporary.c_str());
+            throw std::runtime_error("Snapshot: cannot write " + path);
+        }
+    }
+
+    //Replace the tree's contents with the snapshot at path and return its nextClusterId.
+    //verify re-hashes the whole file first; without it only the header is checked
+    //and pages are read as searches touch them.
+    static int load(ArenaKDTree& tree, const std::string& path, bool verify = true) {
+        auto file = std::make_shared<const MappedFile>(path);
+        if (file->size() < sizeof(Header)) throw std::runtime_error("Snapshot: " + path + " is too short");
+        Header header;
+        std::memcpy(&header, file->data(), sizeof(Header));
+        if (std::memcmp(header.magic, magic, sizeof(header.magic)) != 0) throw std::runtime_error("Snapshot: " + path + " is not a snapshot");
+        if (header.byteOrder != byteOrderMark) throw std::runtime_error("Snapshot: " + path + " was written with the other byte order");
+        if (header.version != formatVersion) throw std::runtime_error("Snapshot: " + path + " has unsupported version " + std::to_string(header.version));
+        if (header.dimensions != tree.dimensions || header.stride != tree.arena.rowStride()) {
+            throw std::runtime_error("Snapshot: " + path + " holds " + std::to_string(header.dimensions) + "-D points");
+        }
+        if (!consistent(header, file->size())) throw std::runtime_error("Snapshot: " + path + " is truncated or malformed");
+        if (verify) {
+            Header zeroed = header;
+            zeroed.checksum = 0;
+            Checksum hash;
+            hash.update(&zeroed, sizeof(Header));
+            hash.update(file->data() + sizeof(Header), file->size() - sizeof(Header));
+            if (hash.value() != header.checksum) throw std::runtime_error("Snapshot: " + path + " fails its checksum");
+        }
+
+        const char* base = file->data();
+        size_t points = header.points;
+        tree.arena = PointArena::view(header.dimensions, reinterpret_cast<const double*>(base + header.rowsOffset), points);
+        std::vector<ArenaKDTree::Node>().swap(tree.pool);
+        tree.mappedPool = reinterpret_cast<const ArenaKDTree::Node*>(base + header.nodesOffset);
+        tree.mappedNodes = header.nodes;
+        tree.mapping = file;
+        tree.removed.assign(base + header.removedOffset, base + header.removedOffset + points);
+        tree.root = header.root;
+        tree.live = header.live;
+        tree.importPointState(points, reinterpret_cast<const int*>(base + header.clustersOffset), base + header.visitedOffset,
+                              reinterpret_cast<const int*>(base + header.countsOffset), header.countRadius);
+        return header.nextClusterId;
+    }
+
+private:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        int32_t dimensions;
+        int32_t root;
+        int32_t live;
+        int32_t nextClusterId;
+        uint64_t points;
+        uint64_t stride;
+        uint64_t nodes;
+        double countRadius;
+        uint64_t rowsOffset;
+        uint64_t nodesOffset;
+        uint64_t removedOffset;
+        uint64_t clustersOffset;
+        uint64_t visitedOffset;
+        uint64_t countsOffset;
+        uint64_t fileSize;
+        uint64_t checksum;
+    };
+    static_assert(sizeof(Header) == 128, "snapshot header layout");
+    static_assert(sizeof(ArenaKDTree::Node) == 16, "snapshot node layout");
+
+    static constexpr char magic[8] = {'I', 'N', 'C', 'D', 'B', 'S', 'N', 'P'};
+    static constexpr uint32_t byteOrderMark = 0x01020304;
+    static constexpr uint64_t sectionAlignment = 64;
+
+    //64-bit hash over the bytes fed to it, a word at a time
+    class Checksum {
+    public:
+        void update(const void* data, size_t bytes) {
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            while (bytes > 0) {
+                if (pending == 0 && bytes >= 8) {
+                    mix(p);
+                    p += 8;
+                    bytes -= 8;
+                    continue;
+                }
+                tail[pending++] = *p++;
+                --bytes;
+                if (pending == 8) {
+                    mix(tail);
+                    pending = 0;
+                }
+            }
+        }
+
+        uint64_t value() const {
+            uint64_t h = state;
+            for (size_t k = 0; k < pending; ++k) h = (h ^ tail[k]) * 0x100000001b3ull;
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdull;
+            h ^= h >> 33;
+            return h;
+        }
+
+    private:
+        uint64_t state = 0xcbf29ce484222325ull;
+        unsigned char tail[8];
+        size_t pending = 0;
+
+        void mix(const unsigned char* word) {
+            uint64_t w;
+            std::memcpy(&w, word, sizeof(w));
+            state = (state ^ (w * 0x9e3779b97f4a7c15ull)) * 0xc2b2ae3d27d4eb4full;
+            state = (state << 31) | (state >> 33);
+        }
+    };
+
+    //fwrite that hashes what it writes and pads sections to the alignment
+    struct Writer {
+        std::FILE* file;
+        Checksum hash;
+        uint64_t written = 0;
+        bool ok = true;
+
+        void write(const void* data, size_t bytes) {
+            if (bytes == 0) return;
+            hash.update(data, bytes);
+            ok = ok && std::fwrite(data, 1, bytes, file) == bytes;
+            written += bytes;
+        }
+
+        void section(const void* data, size_t bytes) {
+            static const char zeros[sectionAlignment] = {};
+            write(data, bytes);
+            write(zeros, aligned(written) - written);
+        }
+    };
+
+    static uint64_t aligned(uint64_t offset) {
+        return (offset + sectionAlignment - 1) / sectionAlignment * sectionAlignment;
+    }
+
+    //Sections in order, aligned and inside the file; root and counts in range
+    static bool consistent(const Header& h, size_t fileSize) {
+        if (h.fileSize != fileSize || h.points > fileSize || h.nodes > h.points || h.live < 0 || static_cast<uint64_t>(h.live) > h.nodes) return false;
+        if (h.root < -1 || (h.root >= 0 && static_cast<uint64_t>(h.root) >= h.nodes) || (h.root < 0) != (h.nodes == 0)) return false;
+        uint64_t offset = sizeof(Header);
+        const uint64_t sections[6][2] = {{h.rowsOffset, h.points * h.stride * sizeof(double)},
+                                         {h.nodesOffset, h.nodes * sizeof(ArenaKDTree::Node)},
+                                         {h.removedOffset, h.points},
+                                         {h.clustersOffset, h.points * sizeof(int32_t)},
+                                         {h.visitedOffset, h.points},
+                                         {h.countsOffset, h.points * sizeof(int32_t)}};
+        for (const auto& section : sections) {
+            if (section[0] != offset) return false;
+            offset = aligned(offset + section[1]);
+        }
+        return offset == fileSize;
+    }
+};
+
+#endif
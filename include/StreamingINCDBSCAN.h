@@ -0,0 +1,177 @@
+// StreamingINCDBSCAN.h
+#ifndef STREAMINGINCDBSCAN_H
+#define STREAMINGINCDBSCAN_H
+
+#include "INCDBSCAN.h"
+#include "BoundedQueue.h"
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+
+// Streaming front end for INCDBSCAN. Producer threads push points into a
+// BoundedQueue and get the point's id back at once: ids are handed out in queue
+// order from a starting id, so callers never track offsets. One clustering
+// thread drains the queue in micro-batches and runs INCDBSCAN::cluster on each.
+// The batch limit follows the measured cost per point so that a batch takes
+// about half the latency target: a point that just misses a batch waits for it
+// and then rides the next one, so it is labeled within roughly the target.
+// A full queue pushes back on producers: push() waits for room, tryPush() fails.
+class StreamingINCDBSCAN {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct BatchReport {
+        int firstId;           // ids firstId .. firstId + size - 1
+        int size;
+        double waitSeconds;    // oldest point's time in the queue before the batch started
+        double clusterSeconds; // INCDBSCAN::cluster on the batch
+        double latencySeconds; // oldest point's push to its label being set
+        int nextBatchLimit;
+        size_t queued;         // points left in the queue after the batch
+    };
+
+    StreamingINCDBSCAN(INCDBSCAN& incdbscan, size_t queueCapacity = 4096, double targetLatencySeconds = 0.5)
+        : incdbscan(incdbscan), queue(queueCapacity), targetLatency(targetLatencySeconds),
+          batchLimit(static_cast<int>(std::min<size_t>(queue.capacity(), 64))) {}
+
+    ~StreamingINCDBSCAN() {
+        finish();
+    }
+
+    StreamingINCDBSCAN(const StreamingINCDBSCAN&) = delete;
+    StreamingINCDBSCAN& operator=(const StreamingINCDBSCAN&) = delete;
+
+    //Called on the clustering thread after every batch; labels may be read from inside it. Set before start()
+    void setBatchCallback(std::function<void(const BatchReport&)> callback) {
+        onBatch = std::move(callback);
+    }
+
+    //Start the clustering thread, before the first push; points get ids from firstId up, new clusters from nextClusterId up
+    void start(int firstId = 0, int nextClusterId = 0) {
+        if (worker.joinable()) return;
+        this->firstId = firstId;
+        this->nextClusterId = nextClusterId;
+        worker = std::thread([this] { run(); });
+    }
+
+    //Queue a point, waiting while the queue is full; returns its id, or -1 once finish() was called
+    int push(std::vector<double> point) {
+        int id;
+        int spins = 0;
+        while (!tryPush(point, id)) {
+            if (closed.load(std::memory_order_acquire)) return -1;
+            if (spins == 0) fullWaits.fetch_add(1, std::memory_order_relaxed);
+            if (++spins < 64) std::this_thread::yield();
+            else std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        return id;
+    }
+
+    //Queue a point unless the queue is full or closed; the point is moved from only on success
+    bool tryPush(std::vector<double>& point, int& id) {
+        if (closed.load(std::memory_order_acquire)) return false;
+        Item item{std::move(point), Clock::now()};
+        size_t position;
+        if (!queue.tryPush(std::move(item), position)) {
+            point = std::move(item.point);
+            return false;
+        }
+        id = firstId + static_cast<int>(position);
+        return true;
+    }
+
+    //Stop accepting points, cluster everything already queued and join the clustering thread.
+    //Call once every push has returned.
+    void finish() {
+        closed.store(true, std::memory_order_release);
+        if (worker.joinable()) worker.join();
+    }
+
+    //Next cluster id INCDBSCAN would hand out; stable once finish() returned
+    int lastClusterId() const {
+        return nextClusterId;
+    }
+
+    //Pushes that found the queue full and had to wait
+    size_t backpressureWaits() const {
+        return fullWaits.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Item {
+        std::vector<double> point;
+        Clock::time_point pushed;
+    };
+
+    INCDBSCAN& incdbscan;
+    BoundedQueue<Item> queue;
+    double targetLatency;
+    int batchLimit;
+    double secondsPerPoint = 0.0;
+    int firstId = 0;
+    int nextClusterId = 0;
+    std::atomic<bool> closed{false};
+    std::atomic<size_t> fullWaits{0};
+    std::function<void(const BatchReport&)> onBatch;
+    std::thread worker;
+
+    void run() {
+        std::vector<Item> batch;
+        Item item;
+        size_t position = 0;
+        int idle = 0;
+        while (true) {
+            //Read before draining: once closed, every push has already been published
+            bool closing = closed.load(std::memory_order_acquire);
+            batch.clear();
+            while (static_cast<int>(batch.size()) < batchLimit && queue.tryPop(item, position)) batch.push_back(std::move(item));
+            if (batch.empty()) {
+                if (closing) return;
+                if (++idle < 64) std::this_thread::yield();
+                else std::this_thread::sleep_for(std::chrono::microseconds(100));
+                continue;
+            }
+            idle = 0;
+            clusterBatch(batch, firstId + static_cast<int>(position) + 1 - static_cast<int>(batch.size()));
+        }
+    }
+
+    void clusterBatch(std::vector<Item>& batch, int batchFirstId) {
+        Clock::time_point start = Clock::now();
+        std::vector<std::vector<double>> points;
+        points.reserve(batch.size());
+        for (Item& item : batch) points.push_back(std::move(item.point));
+        incdbscan.cluster(points, nextClusterId, batchFirstId);
+        incdbscan.getLastClusterId(nextClusterId);
+        Clock::time_point end = Clock::now();
+
+        //Smoothed cost per point sets the next batch limit
+        double seconds = std::chrono::duration<double>(end - start).count();
+        double perPoint = seconds / batch.size();
+        secondsPerPoint = secondsPerPoint > 0.0 ? 0.7 * secondsPerPoint + 0.3 * perPoint : perPoint;
+        double limit = secondsPerPoint > 0.0 ? targetLatency / 2.0 / secondsPerPoint : static_cast<double>(queue.capacity());
+        batchLimit = static_cast<int>(std::clamp(limit, 1.0, static_cast<double>(queue.capacity())));
+
+        BatchReport report;
+        report.firstId = batchFirstId;
+        report.size = static_cast<int>(batch.size());
+        report.waitSeconds = std::chrono::duration<double>(start - batch.front().pushed).count();
+        report.clusterSeconds = seconds;
+        report.latencySeconds = std::chrono::duration<double>(end - batch.front().pushed).count();
+        report.nextBatchLimit = batchLimit;
+        report.queued = queue.sizeApprox();
+        if (onBatch) {
+            onBatch(report);
+        } else if (Metrics::logging()) {
+            std::cout << "Streamed batch of " << report.size << " points from id " << report.firstId << ": waited " << report.waitSeconds
+                      << " s, clustered in " << report.clusterSeconds << " s, latency " << report.latencySeconds << " s, next limit "
+                      << report.nextBatchLimit << ", " << report.queued << " queued" << std::endl;
+        }
+    }
+};
+
+#endif
@@ -7,56 +7,19 @@
 #include <numeric>
 #include <cmath>
 
-#include "../vendor/npy.hpp"
-#include <filesystem>
-
-namespace fs = std::filesystem;
-
-// Function to convert float data to double data
-std::vector<std::vector<double>> convertToDouble(const std::vector<std::vector<float>>& data) {
-    std::vector<std::vector<double>> result;
-    result.reserve(data.size());
-    for (const auto& vec : data) {
-        result.emplace_back(vec.begin(), vec.end());
-    }
-    return result;
-}
-
-
-std::vector<std::vector<float>> load_npy_files(const std::string& base_dir, std::vector<std::string>& labels) {
-    std::vector<std::vector<float>> data;
-
-    for (const auto& moviestar_entry : fs::directory_iterator(base_dir)) {
-        if (moviestar_entry.is_directory()) {
-            std::string moviestar = moviestar_entry.path().filename().string();
-            for (const auto& moviename_entry : fs::directory_iterator(moviestar_entry.path())) {
-                if (moviename_entry.is_directory()) {
-                    for (const auto& npy_file_entry : fs::directory_iterator(moviename_entry.path())) {
-                        if (npy_file_entry.path().extension() == ".npy") {
-                            std::string npy_path = npy_file_entry.path().string();
-                            npy::npy_data d = npy::read_npy<float>(npy_path);  // Correct API call
-                            std::vector<float> embedding = d.data;
-                            data.push_back(embedding);
-                            labels.push_back(moviestar);
-                        }
-                    }
-                }
-            }
-        }
-    }
-
-    return data;
-}
+#include "NpyDataset.h"
+#include "LabelWriter.h"
+#include <fstream>
 
 
 int main() {
 
     std::string base_dir = "./../python/TESTING_SET/";
     
-    std::vector<std::string> labels;
     auto start = std::chrono::high_resolution_clock::now();
-    std::vector<std::vector<float>> data = load_npy_files(base_dir, labels);
-    std::vector<std::vector<double>> doubleData = convertToDouble(data);
+    NpyDataset dataset = NpyDataset::fromDirectory(base_dir);
+    std::vector<std::string> labels = dataset.labelStrings();
+    std::vector<std::vector<double>> doubleData = dataset.toDouble();
     auto end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> load_time = end - start;
     std::cout << "Time taken to load data: " << load_time.count() << " seconds." << std::endl;
@@ -168,14 +131,9 @@ int main() {
     std::vector<int> clusterLabels;
     dbscan.getClustersLabels(clusterLabels, clusterID);
     // Dump it into a file
-    for (size_t i = 0; i < shuffled_doubleData1.size(); ++i) {
-        std::string output_file = "clusters.txt";
-        std::ofstream outfile(output_file, std::ios_base::app);
-        std::string cluster = std::to_string(kdTree.getClusterId(shuffled_doubleData1[i]));
-        std::string result = shuffled_labels1[i] + "," + cluster;
-        outfile << result << std::endl;
-        outfile.close();
-    }
+    CsvLabelWriter clustersFile("clusters.txt", true);
+    clustersFile.write(shuffled_labels1, clusterLabels.data());
+    clustersFile.close();
     end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> print_time = end - start;
     std::cout << "Time taken to print clusters: " << print_time.count() << " seconds." << std::endl;
@@ -193,19 +151,14 @@ int main() {
     start = std::chrono::high_resolution_clock::now();
     std::vector<int> incclusterLabels;
     int incclusterID;
-    // incdbscan.getClustersLabels(incclusterLabels, incclusterID);
+    incdbscan.getClustersLabels(incclusterLabels, startingIndex, startingIndex + static_cast<int>(shuffled_doubleData2.size()));
     incdbscan.getLastClusterId(incclusterID);
     std::cout << "INCDBSCAN clusterID: " << incclusterID << std::endl;
     
     // Dump it into a file
-    for (size_t i = 0; i < shuffled_doubleData2.size(); ++i) {
-        std::string output_file = "incclusters.txt";
-        std::ofstream outfile(output_file, std::ios_base::app);
-        std::string cluster = std::to_string(kdTree.getClusterId(shuffled_doubleData2[i]));
-        std::string result = shuffled_labels2[i] + "," + cluster;
-        outfile << result << std::endl;
-        outfile.close();
-    }
+    CsvLabelWriter incclustersFile("incclusters.txt", true);
+    incclustersFile.write(shuffled_labels2, incclusterLabels.data());
+    incclustersFile.close();
     end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> incprint_time = end - start;
     std::cout << "Time taken to print clusters: " << incprint_time.count() << " seconds." << std::endl;
@@ -216,50 +169,35 @@ int main() {
     
     incdbscan.cluster(shuffled_doubleData3, clusterID, startingIndex);
     std::cout << "INCDBSCAN clustered" << std::endl;
+    KDTree::TreeStats treeStats = kdTree.stats();
+    std::cout << "KDTree height " << treeStats.height << ", average depth " << treeStats.averageDepth
+              << ", balance " << treeStats.balance << ", rebuilds " << treeStats.rebuilds << std::endl;
     start = std::chrono::high_resolution_clock::now();
     std::vector<int> incclusterLabels3;
     int incclusterID3;
-    // incdbscan.getClustersLabels(incclusterLabels3, incclusterID3);
+    incdbscan.getClustersLabels(incclusterLabels3, startingIndex, startingIndex + static_cast<int>(shuffled_doubleData3.size()));
     incdbscan.getLastClusterId(incclusterID3);
     std::cout << "INCDBSCAN clusterID: " << incclusterID3 << std::endl;
 
     // Dump it into a file
-    for (size_t i = 0; i < shuffled_doubleData3.size(); ++i) {
-        std::string output_file = "incclusters2.txt";
-        std::ofstream outfile(output_file, std::ios_base::app);
-        std::string cluster = std::to_string(kdTree.getClusterId(shuffled_doubleData3[i]));
-        std::string result = shuffled_labels3[i] + "," + cluster;
-        outfile << result << std::endl;
-        outfile.close();
-    }
-
-    for(int i = 0; i < shuffled_doubleData1.size(); i++){
-        std::string output_file = "combinedclusters.txt";
-        std::ofstream outfile(output_file, std::ios_base::app);
-        std::string cluster = std::to_string(kdTree.getClusterId(shuffled_doubleData1[i]));
-        std::string result = shuffled_labels1[i] + "," + cluster;
-        outfile << result << std::endl;
-        outfile.close();
-    }
-    for(int i = 0; i < shuffled_doubleData2.size(); i++){
-        std::string output_file = "combinedclusters.txt";
-        std::ofstream outfile(output_file, std::ios_base::app);
-        std::string cluster = std::to_string(kdTree.getClusterId(shuffled_doubleData2[i]));
-        std::string result = shuffled_labels2[i] + "," + cluster;
-        outfile << result << std::endl;
-        outfile.close();
-    }
-    for(int i = 0; i < shuffled_doubleData3.size(); i++){
-        std::string output_file = "combinedclusters.txt";
-        std::ofstream outfile(output_file, std::ios_base::app);
-        std::string cluster = std::to_string(kdTree.getClusterId(shuffled_doubleData3[i]));
-        std::string result = shuffled_labels3[i] + "," + cluster;
-        outfile << result << std::endl;
-        outfile.close();
-    }
+    CsvLabelWriter incclusters2File("incclusters2.txt", true);
+    incclusters2File.write(shuffled_labels3, incclusterLabels3.data());
+    incclusters2File.close();
+
+    //Every point so far, labels read once from the index: ids 0.. follow data1, data2, data3
+    std::vector<int> combinedLabels;
+    kdTree.clusterLabels(combinedLabels, 0, 3*sliced_index);
+    CsvLabelWriter combinedFile("combinedclusters.txt", true);
+    combinedFile.write(shuffled_labels1, combinedLabels.data());
+    combinedFile.write(shuffled_labels2, combinedLabels.data() + sliced_index);
+    combinedFile.write(shuffled_labels3, combinedLabels.data() + 2*sliced_index);
+    combinedFile.close();
     end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> incprint_time3 = end - start;
     std::cout << "Time taken to print clusters: " << incprint_time3.count() << " seconds." << std::endl;
+#if INCDBSCAN_METRICS
+    Metrics::snapshot().print(std::cout);
+#endif
     
     
     return 0;
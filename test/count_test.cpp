@@ -0,0 +1,69 @@
+// Neighbor counts and cached neighborhoods kept current across bulk loads, on
+// KDTree, FixedKDTree, CompactKDTree and BruteForceEngine (whose bulk loads
+// go through one batch query): build a tree, read every count and
+// neighborhood at radius 0.2 (so they are known and cached) and cache one at
+// 0.4 (so updates search wider than the count radius), then build again with
+// more points appended, insert and remove a few, and check every count and
+// cached neighborhood against a fresh radius search. Exits nonzero on any
+// disagreement.
+#include "KDTree.h"
+#include "FixedKDTree.h"
+#include "CompactKDTree.h"
+#include "BruteForceEngine.h"
+#include <iostream>
+#include <random>
+#include <algorithm>
+
+static std::vector<std::vector<double>> uniformPoints(size_t n, int dimensions, std::mt19937& rng) {
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<std::vector<double>> points(n, std::vector<double>(dimensions));
+    for (auto& p : points) {
+        for (double& x : p) x = unit(rng);
+    }
+    return points;
+}
+
+//Ids in 0..bound-1 whose count or cached neighborhood differs from a fresh search
+static int disagreements(NeighborIndex& index, int bound, double radius) {
+    int bad = 0;
+    std::vector<int> fresh, cached;
+    for (int id = 0; id < bound; ++id) {
+        index.radiusSearchById(id, radius, fresh);
+        if (fresh.empty()) continue;
+        index.radiusSearchByIdUsingCache(id, radius, cached);
+        std::sort(fresh.begin(), fresh.end());
+        std::sort(cached.begin(), cached.end());
+        bad += index.neighborCount(id, radius) != static_cast<int>(fresh.size()) || cached != fresh;
+    }
+    return bad;
+}
+
+template <typename Tree>
+static bool check(const char* name, int dimensions, double radius) {
+    std::mt19937 rng(7);
+    Tree tree(dimensions);
+    tree.setCacheBudget(1 << 20);
+    tree.build(uniformPoints(200, dimensions, rng), 0);
+    int bad = disagreements(tree, 200, radius);
+    std::vector<int> wide;
+    tree.radiusSearchByIdUsingCache(0, 2 * radius, wide);
+    tree.build(uniformPoints(200, dimensions, rng), 200);
+    bad += disagreements(tree, 400, radius);
+    std::vector<std::vector<double>> more = uniformPoints(20, dimensions, rng);
+    for (int k = 0; k < 20; ++k) tree.insert(more[k], 400 + k);
+    for (int id = 0; id < 420; id += 7) tree.removeById(id);
+    bad += disagreements(tree, 420, radius);
+    std::cout << name << ": " << bad << " counts or neighborhoods differ" << std::endl;
+    return bad == 0;
+}
+
+int main() {
+    Metrics::setLogging(false);
+    bool ok = check<KDTree>("KDTree", 2, 0.2);
+    ok &= check<FixedKDTree<2>>("FixedKDTree<2>", 2, 0.2);
+    ok &= check<FixedKDTree<2, float>>("FixedKDTree<2, float>", 2, 0.2);
+    ok &= check<CompactKDTree>("CompactKDTree", 2, 0.2);
+    ok &= check<BruteForceEngine>("BruteForceEngine", 2, 0.2);
+    std::cout << (ok ? "OK" : "FAIL") << std::endl;
+    return ok ? 0 : 1;
+}
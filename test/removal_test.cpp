@@ -0,0 +1,131 @@
+// Labels after INCDBSCAN::removePoint / removePoints against re-clustering the
+// survivors. Uniform 2-D points are clustered (DBSCAN on the first batch,
+// INCDBSCAN on the rest), then points are removed in rounds, one at a time and
+// in batches. After every round, with core points found by fresh radius
+// searches over the survivors:
+//  - cores that kept a label are split exactly into the components of cores
+//    that were in the same cluster before the round (no merges, no renames
+//    across clusters, every split found);
+//  - cores and non-core points that had no label still have none;
+//  - a labeled non-core point carries the label of a core neighbor from its
+//    old cluster, or is noise if none is left;
+//  - removed points read -1.
+// Exits nonzero on any violation.
+#include "DBSCAN.h"
+#include "INCDBSCAN.h"
+#include <iostream>
+#include <random>
+#include <map>
+#include <numeric>
+
+struct Survivors {
+    NeighborIndex& index;
+    double eps;
+    int minPts;
+    std::vector<char> gone;
+    std::vector<int> neighbors;
+
+    bool core(int id) {
+        index.radiusSearchById(id, eps, neighbors);
+        return static_cast<int>(neighbors.size()) >= minPts;
+    }
+};
+
+static int find(std::vector<int>& parent, int x) {
+    while (parent[x] != x) x = parent[x] = parent[parent[x]];
+    return x;
+}
+
+//Violations after one removal round, given the labels from before it
+static int violations(Survivors& s, const std::vector<int>& before) {
+    int n = static_cast<int>(s.gone.size());
+    std::vector<int> after;
+    s.index.clusterLabels(after);
+    std::vector<char> core(n, 0);
+    for (int id = 0; id < n; ++id) core[id] = !s.gone[id] && s.core(id);
+
+    //Reference: components of the cores that shared a cluster before the round
+    std::vector<int> parent(n);
+    std::iota(parent.begin(), parent.end(), 0);
+    for (int id = 0; id < n; ++id) {
+        if (!core[id] || before[id] < 0) continue;
+        s.index.radiusSearchById(id, s.eps, s.neighbors);
+        for (int neighbor : s.neighbors) {
+            if (core[neighbor] && before[neighbor] == before[id]) parent[find(parent, neighbor)] = find(parent, id);
+        }
+    }
+
+    int bad = 0;
+    std::map<int, int> componentToLabel, labelToComponent;
+    for (int id = 0; id < n; ++id) {
+        if (s.gone[id]) {
+            bad += after[id] != -1;
+        } else if (core[id] && before[id] >= 0) {
+            int component = find(parent, id);
+            auto a = componentToLabel.emplace(component, after[id]).first;
+            auto b = labelToComponent.emplace(after[id], component).first;
+            bad += after[id] < 0 || a->second != after[id] || b->second != component;
+        } else if (before[id] < 0) {
+            bad += after[id] != -1;
+        } else {
+            //Labeled non-core: a label from a core neighbor of its old cluster, or noise if none is left
+            s.index.radiusSearchById(id, s.eps, s.neighbors);
+            bool any = false, match = false;
+            for (int neighbor : s.neighbors) {
+                if (!core[neighbor] || before[neighbor] != before[id]) continue;
+                any = true;
+                match = match || after[neighbor] == after[id];
+            }
+            bad += any ? !match || after[id] < 0 : after[id] != -1;
+        }
+    }
+    return bad;
+}
+
+int main() {
+    Metrics::setLogging(false);
+    const int points = 1500, batch = 100, removals = 150, trials = 40, minPts = 4;
+    const double eps = 0.03;
+    int total = 0;
+    for (int trial = 0; trial < trials; ++trial) {
+        std::mt19937 rng(trial);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        std::vector<std::vector<double>> all(points, std::vector<double>(2));
+        for (auto& p : all) p = {unit(rng), unit(rng)};
+
+        KDTree tree(2);
+        int clusterId = 0;
+        DBSCAN dbscan(eps, minPts, tree, clusterId);
+        dbscan.cluster(std::vector<std::vector<double>>(all.begin(), all.begin() + batch));
+        std::vector<int> labels;
+        dbscan.getClustersLabels(labels, clusterId);
+        INCDBSCAN incdbscan(eps, minPts, tree);
+        for (int first = batch; first < points; first += batch) {
+            incdbscan.cluster(std::vector<std::vector<double>>(all.begin() + first, all.begin() + first + batch), clusterId, first);
+            incdbscan.getLastClusterId(clusterId);
+        }
+
+        Survivors survivors{tree, eps, minPts, std::vector<char>(points, 0), {}};
+        std::vector<int> order(points);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), rng);
+        int bad = 0;
+        for (int done = 0; done < removals;) {
+            std::vector<int> before;
+            tree.clusterLabels(before);
+            //Alternate single removals and batches of up to 20
+            int take = (done / 10) % 2 ? std::min(20, removals - done) : 1;
+            std::vector<int> ids(order.begin() + done, order.begin() + done + take);
+            for (int id : ids) survivors.gone[id] = 1;
+            if (take == 1) incdbscan.removePoint(ids[0]);
+            else incdbscan.removePoints(ids);
+            done += take;
+            bad += violations(survivors, before);
+        }
+        if (bad) std::cout << "trial " << trial << ": " << bad << " violations" << std::endl;
+        total += bad;
+    }
+    std::cout << trials << " trials, " << total << " violations" << std::endl;
+    std::cout << (total == 0 ? "OK" : "FAIL") << std::endl;
+    return total == 0 ? 0 : 1;
+}